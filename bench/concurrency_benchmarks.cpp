@@ -0,0 +1,273 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+
+// project
+#include "ltb/util/async_task_runner.hpp"
+#include "ltb/util/atomic_data.hpp"
+#include "ltb/util/blocking_queue.hpp"
+#include "ltb/util/concurrent_map.hpp"
+#include "ltb/util/error_sink.hpp"
+#include "ltb/util/metrics.hpp"
+#include "ltb/util/rate_limiter.hpp"
+#include "ltb/util/seqlock_data.hpp"
+#include "ltb/util/triple_buffer.hpp"
+
+// standard
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using namespace ltb;
+
+struct Vec3 {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+};
+
+LTB_BENCHMARK("blocking_queue/push_back + pop_front") {
+    auto queue = util::BlockingQueue<int>{};
+    while (state.keep_running()) {
+        queue.push_back(1);
+        util::do_not_optimize(queue.pop_front());
+    }
+}
+
+LTB_BENCHMARK("blocking_queue/handoff between threads") {
+    constexpr auto batch = 1000;
+    state.set_ops_per_iteration(batch);
+
+    auto queue = util::BlockingQueue<int>{};
+    while (state.keep_running()) {
+        auto consumer = std::thread([&queue] {
+            for (auto i = 0; i < batch; ++i) {
+                util::do_not_optimize(queue.pop_front());
+            }
+        });
+        for (auto i = 0; i < batch; ++i) {
+            queue.push_back(i);
+        }
+        consumer.join();
+    }
+}
+
+LTB_BENCHMARK("atomic_data/use_safely") {
+    auto data = util::AtomicData<Vec3>{};
+    while (state.keep_running()) {
+        data.use_safely([](Vec3& v) { v.x += 1.0; });
+    }
+}
+
+LTB_BENCHMARK("atomic_data/load") {
+    auto data = util::AtomicData<Vec3>{};
+    while (state.keep_running()) {
+        util::do_not_optimize(data.load());
+    }
+}
+
+LTB_BENCHMARK("atomic_data/scoped_lock") {
+    auto data = util::AtomicData<std::string>("some shared string");
+    while (state.keep_running()) {
+        auto locked = data.scoped_lock();
+        util::do_not_optimize(locked->size());
+    }
+}
+
+LTB_BENCHMARK("atomic_data/use_safely_all (2)") {
+    auto from = util::AtomicData<int>(1'000'000);
+    auto to   = util::AtomicData<int>(0);
+    while (state.keep_running()) {
+        util::use_safely_all(
+            [](int& a, int& b) {
+                --a;
+                ++b;
+            },
+            from,
+            to);
+    }
+}
+
+LTB_BENCHMARK("seqlock_data/load") {
+    auto data = util::SeqLockData<Vec3>{};
+    while (state.keep_running()) {
+        util::do_not_optimize(data.load());
+    }
+}
+
+LTB_BENCHMARK("seqlock_data/store") {
+    auto data  = util::SeqLockData<Vec3>{};
+    auto value = Vec3{1.0, 2.0, 3.0};
+    while (state.keep_running()) {
+        util::do_not_optimize(value);
+        data.store(value);
+    }
+}
+
+LTB_BENCHMARK("seqlock_data/load with a concurrent writer") {
+    auto data    = util::SeqLockData<Vec3>{};
+    auto running = std::atomic_bool{true};
+    auto writer  = std::thread([&] {
+        auto value = Vec3{};
+        while (running.load(std::memory_order_relaxed)) {
+            value.x += 1.0;
+            data.store(value);
+        }
+    });
+    while (state.keep_running()) {
+        util::do_not_optimize(data.load());
+    }
+    running = false;
+    writer.join();
+}
+
+LTB_BENCHMARK("concurrent_map/find (hit)") {
+    auto map = util::ConcurrentMap<int, int>{};
+    for (auto i = 0; i < 10'000; ++i) {
+        map.insert_or_assign(i, i);
+    }
+    auto key = 0;
+    while (state.keep_running()) {
+        util::do_not_optimize(map.find(key));
+        key = (key + 7919) % 10'000;
+    }
+}
+
+LTB_BENCHMARK("concurrent_map/insert_or_assign") {
+    auto map = util::ConcurrentMap<int, int>{};
+    auto key = 0;
+    while (state.keep_running()) {
+        util::do_not_optimize(map.insert_or_assign(key, key));
+        key = (key + 7919) % 10'000;
+    }
+}
+
+LTB_BENCHMARK("triple_buffer/write + read") {
+    auto buffer = util::TripleBuffer<Vec3>{};
+    auto value  = Vec3{};
+    while (state.keep_running()) {
+        value.x += 1.0;
+        buffer.write(value);
+        util::do_not_optimize(buffer.read());
+    }
+}
+
+LTB_BENCHMARK("async_task_runner/schedule + callback round trip") {
+    auto runner    = util::AsyncTaskRunner<int>{};
+    auto completed = 0;
+    while (state.keep_running()) {
+        runner.schedule_task([]() -> util::Result<int> { return 1; },
+                             [&completed](int&& value) { completed += value; });
+        runner.invoke_next_callback_blocking();
+    }
+    util::do_not_optimize(completed);
+}
+
+
+LTB_BENCHMARK("metrics/Counter::increment") {
+    auto counter = util::Counter{};
+    while (state.keep_running()) {
+        counter.increment();
+    }
+    util::do_not_optimize(counter.value());
+}
+
+LTB_BENCHMARK("metrics/Counter::increment with a concurrent incrementer") {
+    auto counter = util::Counter{};
+    auto running = std::atomic_bool{true};
+    auto other   = std::thread([&] {
+        while (running.load(std::memory_order_relaxed)) {
+            counter.increment();
+        }
+    });
+    while (state.keep_running()) {
+        counter.increment();
+    }
+    running = false;
+    other.join();
+}
+
+LTB_BENCHMARK("metrics/shared atomic increment with a concurrent incrementer") {
+    auto counter = std::atomic<std::uint64_t>{0u};
+    auto running = std::atomic_bool{true};
+    auto other   = std::thread([&] {
+        while (running.load(std::memory_order_relaxed)) {
+            counter.fetch_add(1u, std::memory_order_relaxed);
+        }
+    });
+    while (state.keep_running()) {
+        counter.fetch_add(1u, std::memory_order_relaxed);
+    }
+    running = false;
+    other.join();
+}
+
+LTB_BENCHMARK("metrics/Histogram::observe") {
+    auto histogram = util::Histogram(util::default_latency_buckets());
+    auto seconds   = 1e-6;
+    while (state.keep_running()) {
+        histogram.observe(seconds);
+        seconds = seconds < 1.0 ? seconds * 1.5 : 1e-6;
+    }
+}
+
+LTB_BENCHMARK("metrics/Histogram::observe with a concurrent observer") {
+    auto histogram = util::Histogram(util::default_latency_buckets());
+    auto running   = std::atomic_bool{true};
+    auto other     = std::thread([&] {
+        auto seconds = 1e-6;
+        while (running.load(std::memory_order_relaxed)) {
+            histogram.observe(seconds);
+            seconds = seconds < 1.0 ? seconds * 1.5 : 1e-6;
+        }
+    });
+    auto seconds = 1e-6;
+    while (state.keep_running()) {
+        histogram.observe(seconds);
+        seconds = seconds < 1.0 ? seconds * 1.5 : 1e-6;
+    }
+    running = false;
+    other.join();
+}
+
+LTB_BENCHMARK("rate_limiter/TokenBucket::try_acquire") {
+    auto bucket = util::TokenBucket(1'000'000'000u, std::chrono::seconds(1), 1'000u);
+    while (state.keep_running()) {
+        util::do_not_optimize(bucket.try_acquire());
+    }
+}
+
+LTB_BENCHMARK("rate_limiter/SlidingWindowLimiter::try_acquire") {
+    auto limiter = util::SlidingWindowLimiter(1'000'000'000u, std::chrono::seconds(1));
+    while (state.keep_running()) {
+        util::do_not_optimize(limiter.try_acquire());
+    }
+}
+
+LTB_BENCHMARK("error_sink/ErrorCallback writing to a stream") {
+    auto       stream   = std::stringstream{};
+    auto const callback = util::ErrorCallback([&stream](util::Error const& error) {
+        stream << error.debug_error_message() << '\n';
+    });
+    while (state.keep_running()) {
+        util::invoke_if_non_null(callback, LTB_MAKE_ERROR("Connection refused"));
+    }
+}
+
+LTB_BENCHMARK("error_sink/AggregatingErrorSink::callback") {
+    auto       stream   = std::stringstream{};
+    auto       write    = [&stream](util::Error const& error) { stream << error.debug_error_message() << '\n'; };
+    auto       sink     = util::AggregatingErrorSink(write, 3u, 1u << 16u);
+    auto const callback = sink.callback();
+    while (state.keep_running()) {
+        util::invoke_if_non_null(callback, LTB_MAKE_ERROR("Connection refused"));
+    }
+}
+
+} // namespace
@@ -0,0 +1,26 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+
+// project
+// Kept out of utility_benchmarks.cpp since enum_bits.hpp and enum_flags.hpp
+// both declare `to_bits` and can't be used in the same file.
+#include "ltb/util/enum_bits.hpp"
+
+namespace {
+
+using namespace ltb;
+
+LTB_BENCHMARK("enum_bits/toggle and test") {
+    enum class Enum : std::uint32_t { Flag1, Flag2, Flag3, Flag4 };
+
+    auto flags = util::to_bits(Enum::Flag1, Enum::Flag3);
+    while (state.keep_running()) {
+        flags = util::toggle_flag(flags, Enum::Flag2);
+        util::do_not_optimize(flags);
+        util::do_not_optimize(util::has_flag(flags, Enum::Flag2));
+    }
+}
+
+} // namespace
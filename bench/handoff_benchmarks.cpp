@@ -0,0 +1,79 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/handoff_benchmark.hpp"
+
+// project
+#include "ltb/util/async_task_runner.hpp"
+#include "ltb/util/atomic_data.hpp"
+#include "ltb/util/blocking_queue.hpp"
+
+// standard
+#include <deque>
+
+namespace {
+
+using namespace ltb;
+
+/// \brief Callbacks are invoked on the consumer thread so this hands the message back to `pop`.
+template <typename Message>
+thread_local Message last_finished_message = {};
+
+LTB_HANDOFF_BENCHMARK("blocking_queue") {
+    return util::visit_handoff_payload(config.payload_bytes, [&config](auto payload_bytes) {
+        using Message = util::HandoffMessage<decltype(payload_bytes)::value>;
+
+        auto queue = util::BlockingQueue<Message>{};
+        return util::run_handoff<Message>(
+            "blocking_queue",
+            config,
+            [&queue](Message message) { queue.push_back(std::move(message)); },
+            [&queue] { return queue.pop_front(); });
+    });
+}
+
+LTB_HANDOFF_BENCHMARK("async_task_runner") {
+    return util::visit_handoff_payload(config.payload_bytes, [&config](auto payload_bytes) {
+        using Message = util::HandoffMessage<decltype(payload_bytes)::value>;
+
+        // Messages pass through the runner's task thread on their way to the consumers.
+        auto runner = util::AsyncTaskRunner<Message>{};
+        return util::run_handoff<Message>(
+            "async_task_runner",
+            config,
+            [&runner](Message message) {
+                runner.schedule_task([message]() -> util::Result<Message> { return message; },
+                                     [](Message&& finished) { last_finished_message<Message> = finished; });
+            },
+            [&runner] {
+                runner.invoke_next_callback_blocking();
+                return last_finished_message<Message>;
+            });
+    });
+}
+
+LTB_HANDOFF_BENCHMARK("atomic_data<deque>") {
+    return util::visit_handoff_payload(config.payload_bytes, [&config](auto payload_bytes) {
+        using Message = util::HandoffMessage<decltype(payload_bytes)::value>;
+
+        // Modifying the data wakes any waiting consumers.
+        auto queue = util::AtomicData<std::deque<Message>>{};
+        return util::run_handoff<Message>(
+            "atomic_data<deque>",
+            config,
+            [&queue](Message message) {
+                queue.use_safely([&message](auto& messages) { messages.push_back(std::move(message)); });
+            },
+            [&queue] {
+                auto message = Message{};
+                queue.wait_to_use_safely([](auto const& messages) { return !messages.empty(); },
+                                         [&message](auto& messages) {
+                                             message = messages.front();
+                                             messages.pop_front();
+                                         });
+                return message;
+            });
+    });
+}
+
+} // namespace
@@ -0,0 +1,29 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+#include "ltb/util/handoff_benchmark.hpp"
+#include "ltb/util/result.hpp"
+
+// standard
+#include <iostream>
+#include <string>
+
+#ifdef LTB_BENCH_IMPLEMENT_DOCTEST
+// The library contains its test cases when testing is enabled so doctest
+// needs to be implemented somewhere, even though the tests aren't run here.
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+#endif
+
+auto main(int argc, char* argv[]) -> int {
+    // `bench_LtbUtilBench --handoff-sweep [options]` writes the producer/consumer sweep as CSV
+    if (argc > 1 && std::string(argv[1]) == "--handoff-sweep") {
+        return ltb::util::handoff_sweep_main(argc - 1, argv + 1);
+    }
+
+    // Errors are returned by value so their size is part of the cost of every `Result`.
+    std::cout << "sizeof(Error) = " << sizeof(ltb::util::Error) << " bytes, sizeof(Result<int>) = "
+              << sizeof(ltb::util::Result<int>) << " bytes\n\n";
+    return ltb::util::benchmark_main(argc, argv);
+}
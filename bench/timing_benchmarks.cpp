@@ -0,0 +1,159 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+
+// project
+#include "ltb/util/clock.hpp"
+#include "ltb/util/latency_histogram.hpp"
+#include "ltb/util/lock_profiler.hpp"
+#include "ltb/util/perf_counters.hpp"
+#include "ltb/util/precise_sleep.hpp"
+#include "ltb/util/thread_clock.hpp"
+#include "ltb/util/timer.hpp"
+#include "ltb/util/timer_sink.hpp"
+#include "ltb/util/tsc_clock.hpp"
+#include "ltb/util/zone_profiler.hpp"
+
+// standard
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+using namespace ltb;
+
+LTB_BENCHMARK("clock/steady_clock::now") {
+    while (state.keep_running()) {
+        util::do_not_optimize(std::chrono::steady_clock::now());
+    }
+}
+
+LTB_BENCHMARK("clock/CoarseClock::now") {
+    while (state.keep_running()) {
+        util::do_not_optimize(util::CoarseClock::now());
+    }
+}
+
+LTB_BENCHMARK("clock/TscClock::now") {
+    util::TscClock::calibrate();
+    while (state.keep_running()) {
+        util::do_not_optimize(util::TscClock::now());
+    }
+}
+
+LTB_BENCHMARK("clock/ThreadCpuClock::now") {
+    while (state.keep_running()) {
+        util::do_not_optimize(util::ThreadCpuClock::now());
+    }
+}
+
+LTB_BENCHMARK("clock/thread_context_switches") {
+    while (state.keep_running()) {
+        util::do_not_optimize(util::thread_context_switches());
+    }
+}
+
+LTB_BENCHMARK("clock/perf counter group read") {
+    auto const& counters = util::this_thread_perf_counters();
+    while (state.keep_running()) {
+        util::do_not_optimize(counters.read());
+    }
+}
+
+// Both should take 100us per op. The difference is how far each overshoots.
+LTB_BENCHMARK("sleep/std::this_thread::sleep_for(100us)") {
+    while (state.keep_running()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+LTB_BENCHMARK("sleep/precise_sleep_for(100us)") {
+    while (state.keep_running()) {
+        util::precise_sleep_for(util::duration_micros(100));
+    }
+}
+
+LTB_BENCHMARK("timer/Timer::elapsed") {
+    auto const timer = util::Timer();
+    while (state.keep_running()) {
+        util::do_not_optimize(timer.elapsed());
+    }
+}
+
+LTB_BENCHMARK("timer/BasicTimer<TscClock>::elapsed") {
+    util::TscClock::calibrate();
+    auto const timer = util::BasicTimer<util::TscClock>();
+    while (state.keep_running()) {
+        util::do_not_optimize(timer.elapsed());
+    }
+}
+
+LTB_BENCHMARK("timer/ThreadTimer::elapsed") {
+    auto const timer = util::ThreadTimer();
+    while (state.keep_running()) {
+        util::do_not_optimize(timer.elapsed());
+    }
+}
+
+LTB_BENCHMARK("timer/ScopedTimer into a histogram") {
+    auto histogram = util::LatencyHistogram{};
+    while (state.keep_running()) {
+        auto scoped_timer = util::ScopedTimer(histogram);
+    }
+}
+
+LTB_BENCHMARK("timer/ScopedTimer printing to a stream") {
+    auto stream = std::stringstream{};
+    while (state.keep_running()) {
+        auto scoped_timer = util::ScopedTimer("benchmark", stream);
+    }
+}
+
+LTB_BENCHMARK("timer/ScopedTimer into an AsyncTimerSink") {
+    auto       stream = std::stringstream{};
+    auto       sink   = util::AsyncTimerSink(stream, 1u << 16u);
+    auto const id     = util::timer_name_id("benchmark");
+    while (state.keep_running()) {
+        auto scoped_timer = util::ScopedTimer(sink, id);
+    }
+}
+
+LTB_BENCHMARK("latency_histogram/record") {
+    auto histogram = util::LatencyHistogram{};
+    auto nanos     = 1;
+    while (state.keep_running()) {
+        histogram.record(util::duration_nanos(nanos));
+        nanos = (nanos * 7) % 100'003;
+    }
+    util::do_not_optimize(histogram.count());
+}
+
+LTB_BENCHMARK("lock_profiler/record_wait") {
+    auto profile = util::LockProfile("benchmark");
+    auto nanos   = 1;
+    while (state.keep_running()) {
+        profile.record_wait(util::duration_nanos(nanos));
+        nanos = (nanos * 7) % 100'003;
+    }
+}
+
+LTB_BENCHMARK("zone_profiler/disabled zone") {
+    util::set_zone_profiling_enabled(false);
+    while (state.keep_running()) {
+        LTB_PROFILE_ZONE("disabled");
+    }
+}
+
+LTB_BENCHMARK("zone_profiler/enabled zone") {
+    util::TscClock::calibrate();
+    util::set_zone_profiling_enabled(true);
+    while (state.keep_running()) {
+        LTB_PROFILE_ZONE("enabled");
+    }
+    util::set_zone_profiling_enabled(false);
+    util::clear_zones();
+}
+
+} // namespace
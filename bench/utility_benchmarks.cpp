@@ -0,0 +1,289 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+
+// project
+#include "ltb/util/comparison_utils.hpp"
+#include "ltb/util/container_utils.hpp"
+#include "ltb/util/enum_flags.hpp"
+#include "ltb/util/error_callback.hpp"
+#include "ltb/util/error_code.hpp"
+#include "ltb/util/file_utils.hpp"
+#include "ltb/util/generic_guard.hpp"
+#include "ltb/util/hash_utils.hpp"
+#include "ltb/util/power_of_2.hpp"
+#include "ltb/util/result.hpp"
+#include "ltb/util/stack_trace.hpp"
+#include "ltb/util/string.hpp"
+#include "ltb/util/type_string.hpp"
+#include "ltb/util/variant_utils.hpp"
+
+// standard
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using namespace ltb;
+
+/// \brief Fails for non-negative inputs. Not inlined so the error is returned like it would be from a real call.
+[[gnu::noinline]] auto fail_if_non_negative(int value, std::string_view message) -> util::Result<int> {
+    if (value >= 0) {
+        return tl::make_unexpected(LTB_MAKE_ERROR(message));
+    }
+    return -value;
+}
+
+enum class ParseError : std::uint8_t {
+    Negative,
+};
+
+constexpr auto error_code_message(ParseError) -> char const* {
+    return "Something went wrong";
+}
+
+[[gnu::noinline]] auto fail_if_non_negative(int value) -> util::Result<int, util::ErrorCode<ParseError>> {
+    if (value >= 0) {
+        return tl::make_unexpected(ParseError::Negative);
+    }
+    return -value;
+}
+
+LTB_BENCHMARK("power_of_2/next_power_of_2") {
+    auto value = std::uint64_t{12345u};
+    while (state.keep_running()) {
+        util::do_not_optimize(value);
+        util::do_not_optimize(util::next_power_of_2(value));
+    }
+}
+
+LTB_BENCHMARK("hash_utils/hash_combine") {
+    auto x = 17;
+    auto y = 42;
+    while (state.keep_running()) {
+        util::do_not_optimize(x);
+        util::do_not_optimize(y);
+        util::do_not_optimize(util::hash_combine(util::hash_combine(0u, x), y));
+    }
+}
+
+LTB_BENCHMARK("hash_utils/string_seed_to_uint") {
+    auto const seed = std::string("a reasonably long random seed string");
+    while (state.keep_running()) {
+        util::do_not_optimize(util::string_seed_to_uint(seed));
+    }
+}
+
+LTB_BENCHMARK("string/starts_with") {
+    auto const str    = std::string("check for prefix in this string");
+    auto const prefix = std::string("check for");
+    while (state.keep_running()) {
+        util::do_not_optimize(util::starts_with(str, prefix));
+    }
+}
+
+LTB_BENCHMARK("string/to_lower_ascii") {
+    auto const str = std::string("Some MIXED case String with MORE than the small buffer");
+    while (state.keep_running()) {
+        util::do_not_optimize(util::to_lower_ascii(str));
+    }
+}
+
+LTB_BENCHMARK("string/to_json_string") {
+    auto const str = std::string("a \"quoted\" name with a \\ backslash");
+    while (state.keep_running()) {
+        util::do_not_optimize(util::to_json_string(str));
+    }
+}
+
+LTB_BENCHMARK("comparison_utils/almost_equal") {
+    auto a = 0.1 + 0.2;
+    auto b = 0.3;
+    while (state.keep_running()) {
+        util::do_not_optimize(a);
+        util::do_not_optimize(b);
+        util::do_not_optimize(util::almost_equal(a, b));
+    }
+}
+
+LTB_BENCHMARK("container_utils/has_key") {
+    auto map = std::map<int, int>{};
+    for (auto i = 0; i < 1000; ++i) {
+        map.emplace(i, i);
+    }
+    auto key = 500;
+    while (state.keep_running()) {
+        util::do_not_optimize(key);
+        util::do_not_optimize(util::has_key(map, key));
+    }
+}
+
+LTB_BENCHMARK("container_utils/has_item (1000 ints)") {
+    auto values = std::vector<int>(1000, 0);
+    values.back() = 1;
+    auto item     = 1;
+    while (state.keep_running()) {
+        util::do_not_optimize(item);
+        util::do_not_optimize(util::has_item(values, item));
+    }
+}
+
+LTB_BENCHMARK("container_utils/remove_all_by_value (1000 ints)") {
+    auto const original = [] {
+        auto values = std::vector<int>(1000);
+        for (auto i = 0u; i < values.size(); ++i) {
+            values[i] = static_cast<int>(i % 4u);
+        }
+        return values;
+    }();
+    auto values = original;
+    while (state.keep_running()) {
+        state.pause_timing();
+        values = original;
+        state.resume_timing();
+
+        util::remove_all_by_value(values, 2);
+        util::do_not_optimize(values.data());
+    }
+}
+
+LTB_BENCHMARK("variant_utils/visit") {
+    auto variant = std::variant<int, float, std::string>(3.0f);
+    while (state.keep_running()) {
+        util::do_not_optimize(variant);
+        auto const result = util::visit(util::Visitor{[](int i) { return double(i); },
+                                                      [](float f) { return double(f); },
+                                                      [](std::string const& s) { return double(s.size()); }},
+                                        variant);
+        util::do_not_optimize(result);
+    }
+}
+
+LTB_BENCHMARK("enum_flags/combine and test") {
+    using namespace util::flag_operators;
+    enum class Enum : std::uint8_t { Flag1, Flag2, Flag3, Flag4 };
+
+    auto flags = util::Flags<Enum>{};
+    while (state.keep_running()) {
+        flags = flags | Enum::Flag2 | Enum::Flag4;
+        util::do_not_optimize(flags.bits);
+        util::do_not_optimize(static_cast<bool>(flags & Enum::Flag4));
+    }
+}
+
+LTB_BENCHMARK("type_string/type_string") {
+    while (state.keep_running()) {
+        util::do_not_optimize(util::type_string<std::map<std::string, std::vector<int>>>());
+    }
+}
+
+LTB_BENCHMARK("generic_guard/make_guard") {
+    auto counter = 0;
+    while (state.keep_running()) {
+        auto guard = util::make_guard([&counter] { ++counter; }, [&counter] { --counter; });
+        util::do_not_optimize(counter);
+    }
+}
+
+LTB_BENCHMARK("error/LTB_MAKE_ERROR") {
+    while (state.keep_running()) {
+        util::do_not_optimize(LTB_MAKE_ERROR("Something went wrong"));
+    }
+}
+
+LTB_BENCHMARK("error/LTB_MAKE_ERROR (stack trace)") {
+    auto const previous = util::set_error_stack_traces_enabled(true);
+    while (state.keep_running()) {
+        util::do_not_optimize(LTB_MAKE_ERROR("Something went wrong"));
+    }
+    util::set_error_stack_traces_enabled(previous);
+}
+
+LTB_BENCHMARK("stack_trace/capture") {
+    while (state.keep_running()) {
+        util::do_not_optimize(util::StackTrace::capture());
+    }
+}
+
+LTB_BENCHMARK("error/round trip") {
+    auto value = 1;
+    while (state.keep_running()) {
+        util::do_not_optimize(value);
+        auto const result = fail_if_non_negative(value, "Something went wrong");
+        util::do_not_optimize(result.error().error_message());
+    }
+}
+
+LTB_BENCHMARK("error/round trip (long message)") {
+    auto value = 1;
+    while (state.keep_running()) {
+        util::do_not_optimize(value);
+        auto const result
+            = fail_if_non_negative(value, "Something went wrong and the message is too long to fit inline");
+        util::do_not_optimize(result.error().error_message());
+    }
+}
+
+LTB_BENCHMARK("error_code/round trip") {
+    auto value = 1;
+    while (state.keep_running()) {
+        util::do_not_optimize(value);
+        auto const result = fail_if_non_negative(value);
+        util::do_not_optimize(result.error().error_message());
+    }
+}
+
+LTB_BENCHMARK("error/copy") {
+    auto const error = LTB_MAKE_ERROR("Something went wrong");
+    while (state.keep_running()) {
+        auto copy = error;
+        util::do_not_optimize(copy);
+    }
+}
+
+LTB_BENCHMARK("error_callback/invoke_if_non_null") {
+    auto       errors   = 0;
+    auto       callback = util::ErrorCallback([&errors](util::Error const&) { ++errors; });
+    auto const error    = LTB_MAKE_ERROR("Something went wrong");
+    while (state.keep_running()) {
+        util::invoke_if_non_null(callback, error);
+        util::do_not_optimize(errors);
+    }
+}
+
+LTB_BENCHMARK("result/map") {
+    auto value = 21;
+    while (state.keep_running()) {
+        util::do_not_optimize(value);
+        auto const result = util::Result<int>(value).map([](int i) { return i * 2; });
+        util::do_not_optimize(result);
+    }
+}
+
+LTB_BENCHMARK("duration/to_millis") {
+    auto duration = util::duration_micros(12345);
+    while (state.keep_running()) {
+        util::do_not_optimize(duration);
+        util::do_not_optimize(util::to_millis<double>(duration));
+    }
+}
+
+LTB_BENCHMARK("file_utils/read_file_to_string (64KB)") {
+    auto const filename = std::filesystem::temp_directory_path() / "ltb_util_read_file_benchmark.txt";
+    {
+        auto output_stream = std::ofstream(filename);
+        output_stream << std::string(64u * 1024u, 'x');
+    }
+    while (state.keep_running()) {
+        util::do_not_optimize(util::read_file_to_string(filename));
+    }
+    std::filesystem::remove(filename);
+}
+
+} // namespace
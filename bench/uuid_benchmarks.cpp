@@ -0,0 +1,67 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+
+// project
+// Kept out of utility_benchmarks.cpp since uuid.hpp needs boost, so this file
+// is only built when boost is found.
+#include "ltb/util/uuid.hpp"
+
+// standard
+#include <functional>
+#include <string>
+
+namespace {
+
+using namespace ltb;
+
+using Id = util::Uuid<struct Tag>;
+
+LTB_BENCHMARK("uuid/UuidGenerator::generate") {
+    auto generator = util::UuidGenerator("benchmark seed");
+    while (state.keep_running()) {
+        util::do_not_optimize(generator.generate<Id>());
+    }
+}
+
+LTB_BENCHMARK("uuid/std::hash") {
+    auto       generator = util::UuidGenerator("benchmark seed");
+    auto const id        = generator.generate<Id>();
+    while (state.keep_running()) {
+        util::do_not_optimize(id);
+        util::do_not_optimize(std::hash<Id>{}(id));
+    }
+}
+
+LTB_BENCHMARK("uuid/operator==") {
+    auto       generator = util::UuidGenerator("benchmark seed");
+    auto const lhs       = generator.generate<Id>();
+    auto const rhs       = Id::from_string(lhs.to_string()); // Equal, so every byte is compared
+    while (state.keep_running()) {
+        util::do_not_optimize(lhs);
+        util::do_not_optimize(rhs);
+        util::do_not_optimize(lhs == rhs);
+    }
+}
+
+LTB_BENCHMARK("uuid/operator<") {
+    auto       generator = util::UuidGenerator("benchmark seed");
+    auto const lhs       = generator.generate<Id>();
+    auto const rhs       = generator.generate<Id>();
+    while (state.keep_running()) {
+        util::do_not_optimize(lhs);
+        util::do_not_optimize(rhs);
+        util::do_not_optimize(lhs < rhs);
+    }
+}
+
+LTB_BENCHMARK("uuid/to_string") {
+    auto       generator = util::UuidGenerator("benchmark seed");
+    auto const id        = generator.generate<Id>();
+    while (state.keep_running()) {
+        util::do_not_optimize(id.to_string());
+    }
+}
+
+} // namespace
@@ -12,6 +12,7 @@ Creates the necessary targets to build a library using doctest.
 
   ltb_create_default_targets(name
                                source_files...
+                               [BENCH_SOURCES bench_files...]
                                )
 
 This function is a bit obscure but is needed to handle
@@ -33,8 +34,17 @@ If testing is enabled, a 4th target will also be created:
    require a main function to compile and run. If no special main function is
    required, ``doctest_with_main`` can be linked to satisfy this requirement.
 
+If benchmarks are enabled and ``BENCH_SOURCES`` are given, another target will
+be created:
+
+5) ``bench_name`` - An executable built from ``BENCH_SOURCES`` that links the
+   main library. One of the sources must provide a main function (usually
+   calling ``ltb::util::benchmark_main``).
+
 #]=======================================================================]
 function(ltb_create_default_targets name)
+    cmake_parse_arguments(PARSE_ARGV 1 LTB "" "" "BENCH_SOURCES")
+
     # ##########################################################################
     # Dependencies
     # ##########################################################################
@@ -57,7 +67,7 @@ function(ltb_create_default_targets name)
 
     # These object files are used to create both the target library and the
     # testing executable.
-    add_library(${name}_objs OBJECT ${ARGN})
+    add_library(${name}_objs OBJECT ${LTB_UNPARSED_ARGUMENTS})
     target_link_libraries(${name}_objs
                           PUBLIC ${name}_deps
                           PRIVATE $<TARGET_NAME_IF_EXISTS:ltb_dev_settings>
@@ -96,4 +106,15 @@ function(ltb_create_default_targets name)
                               )
         add_test(NAME test_${name} COMMAND $<TARGET_FILE:test_${name}>)
     endif()
+
+    # ##########################################################################
+    # Benchmarks
+    # ##########################################################################
+    if(${LTB_ENABLE_BENCHMARKS} AND LTB_BENCH_SOURCES)
+        add_executable(bench_${name} ${LTB_BENCH_SOURCES})
+        target_link_libraries(bench_${name}
+                              PRIVATE ${name}
+                                      $<TARGET_NAME_IF_EXISTS:ltb_dev_settings>
+                              )
+    endif()
 endfunction()
@@ -0,0 +1,58 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "generic_guard.hpp"
+
+// standard
+#include <cstddef>
+#include <cstdint>
+
+namespace ltb::util {
+
+/// \brief Calls to the global `operator new` and `operator delete` made by one thread.
+struct AllocationCounts {
+    std::uint64_t allocations   = 0u;
+    std::uint64_t deallocations = 0u;
+    std::uint64_t bytes         = 0u; ///< Total bytes requested by the allocations
+};
+
+auto operator-(AllocationCounts const& lhs, AllocationCounts const& rhs) -> AllocationCounts;
+
+/// \return true if the `LtbUtil::AllocationHooks` library is linked into the program.
+///         Nothing is counted without it.
+auto allocation_hooks_installed() -> bool;
+
+/// \return Everything allocated by the calling thread since it started.
+auto this_thread_allocations() -> AllocationCounts;
+
+/**
+ * @brief Counts the allocations made by the calling thread while the returned guard is in scope
+ *        and writes them to `counts` when it is destroyed.
+ *
+ * Requires linking `LtbUtil::AllocationHooks`:
+ *
+ *     auto counts = ltb::util::AllocationCounts{};
+ *     {
+ *         auto guard = ltb::util::count_allocations(counts);
+ *         hot_path();
+ *     }
+ *     CHECK(counts.allocations == 0u);
+ */
+inline auto count_allocations(AllocationCounts& counts) {
+    return make_guard([&counts] { counts = this_thread_allocations(); },
+                      [&counts] { counts = this_thread_allocations() - counts; });
+}
+
+namespace detail {
+
+/// \brief Called by the replacement allocation functions.
+auto record_allocation(std::size_t bytes) noexcept -> void;
+auto record_deallocation() noexcept -> void;
+auto set_allocation_hooks_installed() noexcept -> bool;
+
+} // namespace detail
+
+} // namespace ltb::util
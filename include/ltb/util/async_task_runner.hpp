@@ -5,10 +5,12 @@
 
 // project
 #include "blocking_queue.hpp"
+#include "rate_limiter.hpp"
 #include "result.hpp"
 
 // standard
 #include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -25,7 +27,9 @@ public:
 
     /// \brief Creates and AsyncTaskRunner
     /// \param task_ready_callback - Gets called from another thread when tasks are ready.
-    explicit AsyncTaskRunner(NotifyCallback task_ready_callback = nullptr);
+    /// \param rate_limit - Optional. Each task takes a token before it runs. Tasks over the
+    ///                     limit wait in the queue until a token is available (see `rate_limit`).
+    explicit AsyncTaskRunner(NotifyCallback task_ready_callback = nullptr, RateLimit rate_limit = nullptr);
 
     /// \brief Kills the task loop and waits for the task thread to exit.
     ~AsyncTaskRunner();
@@ -76,18 +80,33 @@ private:
     BlockingQueue<std::unique_ptr<TaskToDo>> tasks_to_do_;
     BlockingQueue<FinishedTask>              finished_tasks_;
 
+    RateLimit               rate_limit_;
+    std::mutex              stop_mutex_;
+    std::condition_variable stop_condition_;
+    bool                    stopping_ = false; ///< Interrupts a task waiting on `rate_limit_`
+
     std::thread      task_thread_;
     std::atomic_bool processing_ = false;
 
     auto task_run_loop() -> void;
+
+    /// \return false if the runner is being destroyed.
+    auto wait_for_rate_limit() -> bool;
 };
 
 template <typename T, typename E>
-AsyncTaskRunner<T, E>::AsyncTaskRunner(NotifyCallback task_ready_callback)
-    : finished_tasks_(task_ready_callback), task_thread_([this] { task_run_loop(); }) {}
+AsyncTaskRunner<T, E>::AsyncTaskRunner(NotifyCallback task_ready_callback, RateLimit rate_limit)
+    : finished_tasks_(task_ready_callback),
+      rate_limit_(std::move(rate_limit)),
+      task_thread_([this] { task_run_loop(); }) {}
 
 template <typename T, typename E>
 AsyncTaskRunner<T, E>::~AsyncTaskRunner() {
+    {
+        auto const lock = std::lock_guard(stop_mutex_);
+        stopping_       = true;
+    }
+    stop_condition_.notify_all();
     tasks_to_do_.clear();
     tasks_to_do_.emplace_back(nullptr); // This forces the task run loop to exit.
     task_thread_.join();
@@ -137,6 +156,9 @@ auto AsyncTaskRunner<T, E>::processing() const -> bool {
 template <typename T, typename E>
 auto AsyncTaskRunner<T, E>::task_run_loop() -> void {
     while (std::unique_ptr<TaskToDo> task_to_do = tasks_to_do_.pop_front()) {
+        if (!wait_for_rate_limit()) {
+            break;
+        }
         processing_ = true;
         finished_tasks_.emplace_back(task_to_do->task(),
                                      std::move(task_to_do->on_completion),
@@ -145,4 +167,18 @@ auto AsyncTaskRunner<T, E>::task_run_loop() -> void {
     }
 }
 
+template <typename T, typename E>
+auto AsyncTaskRunner<T, E>::wait_for_rate_limit() -> bool {
+    if (!rate_limit_) {
+        return true;
+    }
+    for (auto wait = rate_limit_(); wait > Duration::zero(); wait = rate_limit_()) {
+        auto lock = std::unique_lock(stop_mutex_);
+        if (stop_condition_.wait_for(lock, wait, [this] { return stopping_; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace ltb::util
@@ -3,17 +3,93 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// project
+#include "clock.hpp"
+#include "cpu.hpp"
+#include "lock_profiler.hpp"
+
+#ifdef LTB_PROFILE_LOCKS
+#include "type_string.hpp"
+#endif
+
 // standard
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <iostream>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace ltb::util {
 
-struct ScopedLock {
-    std::shared_ptr<std::mutex>                  mutex = nullptr;
-    std::shared_ptr<std::lock_guard<std::mutex>> lock  = nullptr;
+template <typename T>
+class AtomicData;
+
+namespace detail {
+struct AtomicDataAccess;
+} // namespace detail
+
+/**
+ * @brief Keeps an AtomicData locked for as long as it exists and provides
+ *        pointer-like access to the data.
+ *
+ * Example:
+ *
+ *     {
+ *         auto data = shared_data.scoped_lock();
+ *         data->thing1 = 1;
+ *         data->more_things.push_back(2.0);
+ *     } // unlocked here
+ *
+ * Releasing a LockedPtr returned by a non-const `scoped_lock` counts as a change
+ * to the data: it bumps the AtomicData's version and wakes any threads waiting on it.
+ */
+template <typename T>
+class LockedPtr {
+public:
+    ~LockedPtr();
+
+    LockedPtr(LockedPtr&& other) noexcept;
+    auto operator=(LockedPtr&& other) noexcept -> LockedPtr&;
+
+    LockedPtr(LockedPtr const&) = delete;
+    auto operator=(LockedPtr const&) -> LockedPtr& = delete;
+
+    [[nodiscard]] auto get() const -> T*;
+    auto               operator->() const -> T*;
+    auto               operator*() const -> T&;
+
+private:
+    friend class AtomicData<std::remove_const_t<T>>;
+
+    using Owner = std::conditional_t<std::is_const_v<T>, AtomicData<std::remove_const_t<T>> const, AtomicData<T>>;
+
+    explicit LockedPtr(std::unique_lock<std::mutex> lock, Owner& owner);
+
+    /// \brief Count this access as a change to the data when it is released.
+    auto mark_changed() -> void;
+
+    /// \brief Unlock the data, bumping the version and waking waiters if it was marked as changed.
+    auto release() -> void;
+
+    /// \brief Record how long it took to acquire the lock and start timing how long it is held.
+    ///        These functions do nothing unless `LTB_PROFILE_LOCKS` is defined.
+    auto start_profiling(LockProfile* profile, detail::LockTimestamp wait_start) -> void;
+    auto restart_hold_timer() -> void;
+    auto stop_profiling() -> void;
+
+    std::unique_lock<std::mutex> lock_;
+    Owner*                       owner_;
+    bool                         changed_ = false;
+
+#ifdef LTB_PROFILE_LOCKS
+    LockProfile*          profile_    = nullptr;
+    detail::LockTimestamp hold_start_ = {};
+#endif
 };
 
 /**
@@ -38,15 +114,35 @@ struct ScopedLock {
  *     });
  *
  *     ...
+ *
+ * The mutex, condition variable, and data are stored inline and the whole object is
+ * aligned to a cache line so neighbouring instances (in an array, for example) don't
+ * contend with each other. As a result, AtomicData is neither copyable nor movable.
+ *
+ * Every non-const access that can change the data (`use_safely`, `store`, `exchange`, a
+ * non-const `scoped_lock`, a `wait_to_use_safely` that runs its function, ...) bumps a
+ * version number and wakes any threads blocked in `wait_to_use_safely` or `wait_for_change`,
+ * so there is no need to call `notify_one` or `notify_all` after changing the data.
+ * Read-only access through a const AtomicData (see `std::as_const`) and timed out waits
+ * never bump the version.
+ *
+ * When the library is built with `LTB_PROFILE_LOCKS` defined, the time spent waiting
+ * for and holding the lock is recorded in a LockProfile named after `T` (or the name
+ * given to `profile_as`). See `dump_lock_profiles`.
  */
 template <typename T>
-class AtomicData {
+class alignas(cache_line_size) AtomicData {
 public:
     explicit AtomicData(T&& data = T{});
 
     template <typename... Args>
     explicit AtomicData(Args&&... args);
 
+    AtomicData(AtomicData const&) = delete;
+    AtomicData(AtomicData&&)      = delete;
+    auto operator=(AtomicData const&) -> AtomicData& = delete;
+    auto operator=(AtomicData&&) -> AtomicData& = delete;
+
     /// \brief Use the data in a thread safe manner.
     template <typename Func>
     auto use_safely(Func func);
@@ -59,109 +155,301 @@ public:
     auto load() const -> T;
 
     /// \brief Safely set the data (name is taken from std::atomic::store).
-    auto store(T t) -> void;
+    auto store(T data) -> void;
+
+    /// \brief Safely replace the data and return the previous value (name is taken from std::atomic::exchange).
+    auto exchange(T data) -> T;
 
-    /// \brief Wait for 'notify_one' or 'notify_all' to be called
+    /// \brief Wait for the data to change (or 'notify_one' or 'notify_all' to be called)
     ///        before using the data in a thread safe manner.
     /// \param predicate - a predicate that must be true for `func` to be invoked.
     template <typename Pred, typename Func>
     auto wait_to_use_safely(Pred predicate, Func func) -> void;
 
-    /// \brief Wait for 'notify_one' or 'notify_all' to be called
+    /// \brief Wait for the data to change (or 'notify_one' or 'notify_all' to be called)
     ///        before using the data in a thread safe manner.
     /// \param predicate - a predicate that must be true for `func` to be invoked.
     template <typename Pred, typename Func>
     auto wait_to_use_safely(Pred predicate, Func func) const -> void;
 
-    /// \brief Wait for 'notify_one' or 'notify_all' to be called
+    /// \brief Wait for the data to change (or 'notify_one' or 'notify_all' to be called)
     ///        before using the data in a thread safe manner.
-    /// \param duration - the maximum length of time this function will wait before returning.
+    /// \param duration - the maximum length of time (measured by `Clock`) this function will wait before returning.
     /// \param predicate - a predicate that must be true for `func` to be invoked.
-    template <typename Rep, typename Period, typename Pred, typename Func>
+    template <typename Clock = SteadyClock, typename Rep, typename Period, typename Pred, typename Func>
     auto wait_to_use_safely(std::chrono::duration<Rep, Period> const& duration, Pred predicate, Func func) -> bool;
 
-    /// \brief Wait for 'notify_one' or 'notify_all' to be called
+    /// \brief Wait for the data to change (or 'notify_one' or 'notify_all' to be called)
     ///        before using the data in a thread safe manner.
-    /// \param duration - the maximum length of time this function will wait before returning.
+    /// \param duration - the maximum length of time (measured by `Clock`) this function will wait before returning.
     /// \param predicate - a predicate that must be true for `func` to be invoked.
-    template <typename Rep, typename Period, typename Pred, typename Func>
+    template <typename Clock = SteadyClock, typename Rep, typename Period, typename Pred, typename Func>
     auto wait_to_use_safely(std::chrono::duration<Rep, Period> const& duration, Pred predicate, Func func) const
         -> bool;
 
-    /// \brief Allow one 'wait_to_use_safely' function to continue.
+    /// \brief The number of times the data has been changed. Starts at zero.
+    [[nodiscard]] auto version() const -> std::uint64_t;
+
+    /// \brief Block until the version is different from `since_version` or `timeout` has passed.
+    ///        Only changes to the data wake this function so the version is checked without
+    ///        touching the data itself.
+    /// \return The current version. It is equal to `since_version` if the wait timed out.
+    template <typename Clock = SteadyClock, typename Rep, typename Period>
+    auto wait_for_change(std::uint64_t since_version, std::chrono::duration<Rep, Period> const& timeout) const
+        -> std::uint64_t;
+
+    /// \brief Allow one 'wait_to_use_safely' function to continue. Does nothing if no threads are waiting.
     auto notify_one() -> void;
 
-    /// \brief Allow all 'wait_to_use_safely' functions to continue.
+    /// \brief Allow all 'wait_to_use_safely' functions to continue. Does nothing if no threads are waiting.
     auto notify_all() -> void;
 
-    /// \brief Prevent this data from being accessed until the returned object is destructed.
-    [[nodiscard]] auto scoped_lock() const -> ScopedLock;
+    /// \brief Prevent this data from being accessed by other threads until the returned object is destructed.
+    [[nodiscard]] auto scoped_lock() -> LockedPtr<T>;
+
+    /// \brief Prevent this data from being accessed by other threads until the returned object is destructed.
+    [[nodiscard]] auto scoped_lock() const -> LockedPtr<T const>;
+
+    /// \brief Record lock times under `name` instead of the name of `T`.
+    ///        Does nothing unless `LTB_PROFILE_LOCKS` is defined.
+    auto profile_as(std::string const& name) -> void;
 
 private:
-    std::shared_ptr<std::mutex>              lock_;
-    std::shared_ptr<std::condition_variable> condition_;
-    T                                        data_;
+    friend struct detail::AtomicDataAccess;
+
+    template <typename U>
+    friend class LockedPtr;
+
+    mutable std::mutex                 mutex_;
+    mutable std::condition_variable    condition_;
+    T                                  data_;
+    std::atomic<std::uint64_t>         version_ = {0u}; ///< Only incremented while `mutex_` is locked
+    mutable std::atomic<std::uint32_t> waiters_ = {0u}; ///< Threads blocked on `condition_`
+
+#ifdef LTB_PROFILE_LOCKS
+    std::atomic<LockProfile*> profile_ = {&lock_profile(type_string<T>())};
+#endif
+
+    /// \brief Lock the data without counting the access as a change.
+    auto lock_unchanged() -> LockedPtr<T>;
+
+    /// \brief Wrap the data in a LockedPtr when `mutex_` has already been locked by this thread.
+    auto adopt_lock(detail::LockTimestamp wait_start) -> LockedPtr<T>;
+    auto adopt_lock(detail::LockTimestamp wait_start) const -> LockedPtr<T const>;
+
+    auto profile() const -> LockProfile*;
+
+    /// \brief Wait on `condition_` while letting notifiers know someone is waiting.
+    template <typename Pred>
+    auto wait(std::unique_lock<std::mutex>& lock, Pred predicate) const -> void;
+
+    template <typename Clock, typename Rep, typename Period, typename Pred>
+    auto wait_for(std::unique_lock<std::mutex>&             lock,
+                  std::chrono::duration<Rep, Period> const& duration,
+                  Pred                                      predicate) const -> bool;
 };
 
+/**
+ * @brief Lock several AtomicData objects at once and use all of their data in a thread safe manner.
+ *
+ * The mutexes are acquired together using `std::lock` so two threads locking the
+ * same objects in different orders can't deadlock each other. The same object
+ * must not be passed more than once.
+ *
+ * Example:
+ *
+ *     ltb::util::use_safely_all([] (Account& from, Account& to, Ledger const& ledger) {
+ *         ...
+ *     }, from_account, to_account, std::as_const(ledger));
+ */
+template <typename Func, typename... AtomicDatas>
+auto use_safely_all(Func func, AtomicDatas&... atomic_datas);
+
+namespace detail {
+
+struct AtomicDataAccess {
+    template <typename T>
+    static auto mutex(AtomicData<T> const& atomic_data) -> std::mutex& {
+        return atomic_data.mutex_;
+    }
+
+    template <typename T>
+    static auto adopt_lock(AtomicData<T>& atomic_data, LockTimestamp wait_start) -> LockedPtr<T> {
+        return atomic_data.adopt_lock(wait_start);
+    }
+
+    template <typename T>
+    static auto adopt_lock(AtomicData<T> const& atomic_data, LockTimestamp wait_start) -> LockedPtr<T const> {
+        return atomic_data.adopt_lock(wait_start);
+    }
+};
+
+} // namespace detail
+
+template <typename T>
+LockedPtr<T>::LockedPtr(std::unique_lock<std::mutex> lock, Owner& owner) : lock_(std::move(lock)), owner_(&owner) {}
+
+template <typename T>
+LockedPtr<T>::~LockedPtr() {
+    release();
+}
+
+template <typename T>
+LockedPtr<T>::LockedPtr(LockedPtr&& other) noexcept
+    : lock_(std::move(other.lock_)),
+      owner_(std::exchange(other.owner_, nullptr)),
+      changed_(std::exchange(other.changed_, false)) {
+#ifdef LTB_PROFILE_LOCKS
+    profile_    = std::exchange(other.profile_, nullptr);
+    hold_start_ = other.hold_start_;
+#endif
+}
+
+template <typename T>
+auto LockedPtr<T>::operator=(LockedPtr&& other) noexcept -> LockedPtr& {
+    release();
+    lock_  = std::move(other.lock_);
+    owner_   = std::exchange(other.owner_, nullptr);
+    changed_ = std::exchange(other.changed_, false);
+#ifdef LTB_PROFILE_LOCKS
+    profile_    = std::exchange(other.profile_, nullptr);
+    hold_start_ = other.hold_start_;
+#endif
+    return *this;
+}
+
+template <typename T>
+auto LockedPtr<T>::get() const -> T* {
+    return owner_ ? &owner_->data_ : nullptr;
+}
+
+template <typename T>
+auto LockedPtr<T>::operator->() const -> T* {
+    return get();
+}
+
+template <typename T>
+auto LockedPtr<T>::operator*() const -> T& {
+    return owner_->data_;
+}
+
+template <typename T>
+auto LockedPtr<T>::mark_changed() -> void {
+    changed_ = true;
+}
+
+template <typename T>
+auto LockedPtr<T>::release() -> void {
+    stop_profiling();
+
+    if constexpr (!std::is_const_v<T>) {
+        if (lock_.owns_lock() && std::exchange(changed_, false)) {
+            owner_->version_.fetch_add(1u, std::memory_order_release);
+
+            // Notify while the lock is still held so a woken thread can't destroy
+            // the AtomicData before we're finished with it.
+            if (owner_->waiters_.load() > 0u) {
+                owner_->condition_.notify_all();
+            }
+        }
+    }
+
+    if (lock_.owns_lock()) {
+        lock_.unlock();
+    }
+}
+
+template <typename T>
+auto LockedPtr<T>::start_profiling([[maybe_unused]] LockProfile*          profile,
+                                   [[maybe_unused]] detail::LockTimestamp wait_start) -> void {
+#ifdef LTB_PROFILE_LOCKS
+    profile_    = profile;
+    hold_start_ = detail::lock_timestamp();
+    profile_->record_wait(hold_start_ - wait_start);
+#endif
+}
+
+template <typename T>
+auto LockedPtr<T>::restart_hold_timer() -> void {
+#ifdef LTB_PROFILE_LOCKS
+    hold_start_ = detail::lock_timestamp();
+#endif
+}
+
+template <typename T>
+auto LockedPtr<T>::stop_profiling() -> void {
+#ifdef LTB_PROFILE_LOCKS
+    if (profile_ && lock_.owns_lock()) {
+        profile_->record_hold(detail::lock_timestamp() - hold_start_);
+    }
+    profile_ = nullptr;
+#endif
+}
+
 template <typename T>
-AtomicData<T>::AtomicData(T&& data)
-    : lock_(std::make_shared<std::mutex>()),
-      condition_(std::make_shared<std::condition_variable>()),
-      data_(std::forward<T>(data)) {}
+AtomicData<T>::AtomicData(T&& data) : data_(std::forward<T>(data)) {}
 
 template <typename T>
 template <typename... Args>
-AtomicData<T>::AtomicData(Args&&... args)
-    : lock_(std::make_shared<std::mutex>()),
-      condition_(std::make_shared<std::condition_variable>()),
-      data_(std::forward<Args>(args)...) {}
+AtomicData<T>::AtomicData(Args&&... args) : data_(std::forward<Args>(args)...) {}
 
 template <typename T>
 template <typename Func>
 auto AtomicData<T>::use_safely(Func func) {
-    std::lock_guard<std::mutex> scoped_lock(*lock_);
-    return func(data_);
+    auto locked_data = lock_unchanged();
+    locked_data.mark_changed();
+    return func(*locked_data);
 }
 
 template <typename T>
 template <typename Func>
 auto AtomicData<T>::use_safely(Func func) const {
-    std::lock_guard<std::mutex> scoped_lock(*lock_);
-    return func(data_);
+    auto locked_data = scoped_lock();
+    return func(*locked_data);
 }
 
 template <typename T>
 auto AtomicData<T>::load() const -> T {
-    return use_safely([](auto data) { return data; });
+    return use_safely([](T const& data) { return data; });
 }
 
 template <typename T>
 auto AtomicData<T>::store(T data) -> void {
-    use_safely([data](auto& stored_data) { stored_data = data; });
+    use_safely([&data](T& stored_data) { stored_data = std::move(data); });
+}
+
+template <typename T>
+auto AtomicData<T>::exchange(T data) -> T {
+    return use_safely([&data](T& stored_data) { return std::exchange(stored_data, std::move(data)); });
 }
 
 template <typename T>
 template <typename Pred, typename Func>
 auto AtomicData<T>::wait_to_use_safely(Pred predicate, Func func) -> void {
-    std::unique_lock<std::mutex> unlockable_lock(*lock_);
-    condition_->wait(unlockable_lock, [&] { return predicate(data_); });
+    auto locked_data = lock_unchanged();
+    wait(locked_data.lock_, [&] { return predicate(data_); });
+    locked_data.restart_hold_timer();
+    locked_data.mark_changed();
     func(data_);
 }
 
 template <typename T>
 template <typename Pred, typename Func>
 auto AtomicData<T>::wait_to_use_safely(Pred predicate, Func func) const -> void {
-    std::unique_lock<std::mutex> unlockable_lock(*lock_);
-    condition_->wait(unlockable_lock, [&] { return predicate(data_); });
+    auto locked_data = scoped_lock();
+    wait(locked_data.lock_, [&] { return predicate(data_); });
+    locked_data.restart_hold_timer();
     func(data_);
 }
 
 template <typename T>
-template <typename Rep, typename Period, typename Pred, typename Func>
+template <typename Clock, typename Rep, typename Period, typename Pred, typename Func>
 auto AtomicData<T>::wait_to_use_safely(std::chrono::duration<Rep, Period> const& duration, Pred predicate, Func func)
     -> bool {
-    std::unique_lock<std::mutex> unlockable_lock(*lock_);
-    if (condition_->wait_for(unlockable_lock, duration, [&] { return predicate(data_); })) {
+    auto locked_data = lock_unchanged();
+    if (wait_for<Clock>(locked_data.lock_, duration, [&] { return predicate(data_); })) {
+        locked_data.restart_hold_timer();
+        locked_data.mark_changed();
         func(data_);
         return true;
     }
@@ -169,33 +457,140 @@ auto AtomicData<T>::wait_to_use_safely(std::chrono::duration<Rep, Period> const&
 }
 
 template <typename T>
-template <typename Rep, typename Period, typename Pred, typename Func>
+template <typename Clock, typename Rep, typename Period, typename Pred, typename Func>
 auto AtomicData<T>::wait_to_use_safely(std::chrono::duration<Rep, Period> const& duration,
                                        Pred                                      predicate,
                                        Func                                      func) const -> bool {
-    std::unique_lock<std::mutex> unlockable_lock(*lock_);
-    if (condition_->wait_for(unlockable_lock, duration, [&] { return predicate(data_); })) {
+    auto locked_data = scoped_lock();
+    if (wait_for<Clock>(locked_data.lock_, duration, [&] { return predicate(data_); })) {
+        locked_data.restart_hold_timer();
         func(data_);
         return true;
     }
     return false;
 }
 
+template <typename T>
+auto AtomicData<T>::version() const -> std::uint64_t {
+    return version_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+template <typename Clock, typename Rep, typename Period>
+auto AtomicData<T>::wait_for_change(std::uint64_t                             since_version,
+                                    std::chrono::duration<Rep, Period> const& timeout) const -> std::uint64_t {
+    if (auto const current = version(); current != since_version) {
+        return current;
+    }
+
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    wait_for<Clock>(lock, timeout, [this, since_version] {
+        return version_.load(std::memory_order_relaxed) != since_version;
+    });
+    return version_.load(std::memory_order_relaxed);
+}
+
 template <typename T>
 auto AtomicData<T>::notify_one() -> void {
-    condition_->notify_one();
+    if (waiters_.load() > 0u) {
+        condition_.notify_one();
+    }
 }
 
 template <typename T>
 auto AtomicData<T>::notify_all() -> void {
-    condition_->notify_all();
+    if (waiters_.load() > 0u) {
+        condition_.notify_all();
+    }
+}
+
+template <typename T>
+auto AtomicData<T>::scoped_lock() -> LockedPtr<T> {
+    auto locked_data = lock_unchanged();
+    locked_data.mark_changed();
+    return locked_data;
+}
+
+template <typename T>
+auto AtomicData<T>::scoped_lock() const -> LockedPtr<T const> {
+    auto const wait_start  = detail::lock_timestamp();
+    auto       locked_data = LockedPtr<T const>(std::unique_lock<std::mutex>(mutex_), *this);
+    locked_data.start_profiling(profile(), wait_start);
+    return locked_data;
+}
+
+template <typename T>
+auto AtomicData<T>::profile_as([[maybe_unused]] std::string const& name) -> void {
+#ifdef LTB_PROFILE_LOCKS
+    profile_ = &lock_profile(name);
+#endif
+}
+
+template <typename T>
+auto AtomicData<T>::lock_unchanged() -> LockedPtr<T> {
+    auto const wait_start  = detail::lock_timestamp();
+    auto       locked_data = LockedPtr<T>(std::unique_lock<std::mutex>(mutex_), *this);
+    locked_data.start_profiling(profile(), wait_start);
+    return locked_data;
 }
 
 template <typename T>
-auto AtomicData<T>::scoped_lock() const -> ScopedLock {
-    ScopedLock lock{lock_};
-    lock.lock = std::make_shared<std::lock_guard<std::mutex>>(*lock.mutex);
-    return lock;
+auto AtomicData<T>::adopt_lock(detail::LockTimestamp wait_start) -> LockedPtr<T> {
+    auto locked_data = LockedPtr<T>(std::unique_lock<std::mutex>(mutex_, std::adopt_lock), *this);
+    locked_data.start_profiling(profile(), wait_start);
+    locked_data.mark_changed();
+    return locked_data;
+}
+
+template <typename T>
+auto AtomicData<T>::adopt_lock(detail::LockTimestamp wait_start) const -> LockedPtr<T const> {
+    auto locked_data = LockedPtr<T const>(std::unique_lock<std::mutex>(mutex_, std::adopt_lock), *this);
+    locked_data.start_profiling(profile(), wait_start);
+    return locked_data;
+}
+
+template <typename T>
+auto AtomicData<T>::profile() const -> LockProfile* {
+#ifdef LTB_PROFILE_LOCKS
+    return profile_.load(std::memory_order_relaxed);
+#else
+    return nullptr;
+#endif
+}
+
+template <typename T>
+template <typename Pred>
+auto AtomicData<T>::wait(std::unique_lock<std::mutex>& lock, Pred predicate) const -> void {
+    ++waiters_;
+    condition_.wait(lock, predicate);
+    --waiters_;
+}
+
+template <typename T>
+template <typename Clock, typename Rep, typename Period, typename Pred>
+auto AtomicData<T>::wait_for(std::unique_lock<std::mutex>&             lock,
+                             std::chrono::duration<Rep, Period> const& duration,
+                             Pred                                      predicate) const -> bool {
+    auto const deadline = Clock::now() + std::chrono::duration_cast<typename Clock::duration>(duration);
+    ++waiters_;
+    auto const satisfied = ClockTraits<Clock>::wait_until(condition_, lock, deadline, predicate);
+    --waiters_;
+    return satisfied;
+}
+
+template <typename Func, typename... AtomicDatas>
+auto use_safely_all(Func func, AtomicDatas&... atomic_datas) {
+    static_assert(sizeof...(AtomicDatas) > 0u, "use_safely_all requires at least one AtomicData");
+
+    auto const wait_start = detail::lock_timestamp();
+    if constexpr (sizeof...(AtomicDatas) == 1u) {
+        (detail::AtomicDataAccess::mutex(atomic_datas).lock(), ...);
+    } else {
+        std::lock(detail::AtomicDataAccess::mutex(atomic_datas)...);
+    }
+    auto locked_data = std::make_tuple(detail::AtomicDataAccess::adopt_lock(atomic_datas, wait_start)...);
+
+    return std::apply([&func](auto&... data) { return func(*data...); }, locked_data);
 }
 
 } // namespace ltb::util
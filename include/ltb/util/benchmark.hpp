@@ -0,0 +1,150 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+#include "timer.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// standard
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ltb::util {
+
+/**
+ * @brief Passed to each benchmark to control how many iterations are timed.
+ *
+ * Only the loop is timed so setup can be done before it:
+ *
+ *     LTB_BENCHMARK("next_power_of_2") {
+ *         auto value = std::uint64_t{12345u};
+ *         while (state.keep_running()) {
+ *             ltb::util::do_not_optimize(ltb::util::next_power_of_2(value));
+ *         }
+ *     }
+ */
+class BenchmarkState {
+public:
+    explicit BenchmarkState(std::uint64_t iterations);
+
+    /// \return true until the requested number of iterations have run. The timer
+    ///         starts on the first call and stops when this returns false.
+    auto keep_running() -> bool;
+
+    /// \brief Stop timing temporarily, for per-iteration setup that shouldn't be measured.
+    auto pause_timing() -> void;
+    auto resume_timing() -> void;
+
+    /// \brief The number of operations done per iteration (defaults to 1). Results are reported per operation.
+    auto set_ops_per_iteration(std::uint64_t ops) -> void;
+
+    [[nodiscard]] auto iterations() const -> std::uint64_t;
+    [[nodiscard]] auto ops_per_iteration() const -> std::uint64_t;
+    [[nodiscard]] auto elapsed() const -> Duration;
+
+private:
+    std::uint64_t iterations_;
+    std::uint64_t remaining_;
+    std::uint64_t ops_per_iteration_ = 1u;
+    bool          running_           = false;
+    Timer         timer_;
+    Duration      elapsed_           = {};
+};
+
+using BenchmarkFunction = std::function<void(BenchmarkState&)>;
+
+struct BenchmarkOptions {
+    Duration      warm_up_time = duration_millis(50);
+    Duration      sample_time  = duration_millis(10); ///< Iterations are chosen so each sample takes this long
+    std::uint64_t sample_count = 20u;
+    std::string   filter       = {}; ///< Only run benchmarks whose names contain this string
+};
+
+/// \brief Nanoseconds per operation over all samples of one benchmark.
+struct BenchmarkResult {
+    std::string   name;
+    std::uint64_t iterations_per_sample = 0u;
+    std::uint64_t sample_count          = 0u;
+    double        min_nanos             = 0.0;
+    double        median_nanos          = 0.0;
+    double        mean_nanos            = 0.0;
+    double        stddev_nanos          = 0.0;
+};
+
+/// \brief Add a benchmark to be run by `run_benchmarks`. Prefer the `LTB_BENCHMARK` macro.
+auto register_benchmark(std::string name, BenchmarkFunction function) -> bool;
+
+/// \brief Warm up then time each registered benchmark, printing a line per benchmark to `os`.
+auto run_benchmarks(BenchmarkOptions const& options, std::ostream& os) -> std::vector<BenchmarkResult>;
+
+/// \brief Warm up then time a single benchmark.
+auto run_benchmark(std::string const& name, BenchmarkFunction const& function, BenchmarkOptions const& options)
+    -> BenchmarkResult;
+
+auto write_benchmark_json(std::ostream& os, std::vector<BenchmarkResult> const& results) -> void;
+
+/// \brief Parses `--filter <str>`, `--samples <n>`, `--sample-ms <n>` and `--json <file>`
+///        then runs the registered benchmarks. Returns an exit code. Prints the usage and
+///        returns 1 for unknown options or counts that aren't positive integers.
+auto benchmark_main(int argc, char const* const* argv) -> int;
+
+/// \brief A command line count, or nullopt if `arg` isn't entirely a positive integer.
+auto parse_benchmark_count(std::string const& arg) -> std::optional<std::uint64_t>;
+
+/// \brief Prevent the compiler from optimizing away `value` or the work done to compute it.
+template <typename T>
+inline auto do_not_optimize(T const& value) -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    auto const volatile* sink = &value;
+    static_cast<void>(sink);
+    _ReadWriteBarrier();
+#endif
+}
+
+/// \brief Prevent the compiler from optimizing away `value` or the work done to compute it,
+///        and assume `value` may be modified.
+template <typename T>
+inline auto do_not_optimize(T& value) -> void {
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#elif defined(__GNUC__)
+    asm volatile("" : "+m,r"(value) : : "memory");
+#else
+    auto volatile* sink = &value;
+    static_cast<void>(sink);
+    _ReadWriteBarrier();
+#endif
+}
+
+/// \brief Force all pending writes to memory to be completed before continuing.
+inline auto clobber_memory() -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+} // namespace ltb::util
+
+#define LTB_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define LTB_BENCHMARK_CONCAT(a, b) LTB_BENCHMARK_CONCAT_IMPL(a, b)
+
+///\brief Define and register a benchmark. The body has access to `ltb::util::BenchmarkState& state`.
+#define LTB_BENCHMARK(name)                                                                                            \
+    static auto LTB_BENCHMARK_CONCAT(ltb_benchmark_, __LINE__)(::ltb::util::BenchmarkState & state)->void;             \
+    static auto const LTB_BENCHMARK_CONCAT(ltb_benchmark_registered_, __LINE__)                                        \
+        = ::ltb::util::register_benchmark(name, &LTB_BENCHMARK_CONCAT(ltb_benchmark_, __LINE__));                      \
+    static auto LTB_BENCHMARK_CONCAT(ltb_benchmark_, __LINE__)(::ltb::util::BenchmarkState & state)->void
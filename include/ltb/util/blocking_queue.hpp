@@ -3,6 +3,9 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// project
+#include "clock.hpp"
+
 // system
 #include <condition_variable>
 #include <memory>
@@ -34,6 +37,8 @@ public:
     auto pop_front() -> T;
 
     /// \return the front element or std::nullopt if the timeout is reached.
+    /// \tparam Clock - measures the timeout. Use `ManualClock` to test timeouts without waiting.
+    template <typename Clock = SteadyClock>
     auto pop_front(std::chrono::nanoseconds timeout) -> std::optional<T>;
 
     auto clear() -> void;
@@ -86,9 +91,11 @@ auto BlockingQueue<T>::pop_front() -> T {
 }
 
 template <typename T>
+template <typename Clock>
 auto BlockingQueue<T>::pop_front(std::chrono::nanoseconds timeout) -> std::optional<T> {
+    auto const deadline = Clock::now() + std::chrono::duration_cast<typename Clock::duration>(timeout);
     std::unique_lock lock(mutex_);
-    if (condition_.wait_for(lock, timeout, [this] { return !queue_.empty(); })) {
+    if (ClockTraits<Clock>::wait_until(condition_, lock, deadline, [this] { return !queue_.empty(); })) {
         T rc(std::move(queue_.front()));
         queue_.pop(); // pop_front
         return rc;
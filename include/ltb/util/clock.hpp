@@ -0,0 +1,165 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+
+// standard
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace ltb::util {
+
+/**
+ * @brief The default clock for timeouts and timers.
+ *
+ * Timeouts and timers in this library take a `Clock` template parameter that defaults to
+ * `std::chrono::steady_clock`. Any type meeting the standard Clock requirements works, and
+ * `ClockTraits` can be specialized for clocks that don't advance on their own. Provided clocks:
+ *
+ *   - `SteadyClock`: `std::chrono::steady_clock`.
+ *   - `CoarseClock`: much cheaper to read but only advances every few milliseconds.
+ *   - `ManualClock`: only advances when told to, for deterministic tests of timeout logic.
+ *
+ * Example:
+ *
+ *     auto queue = ltb::util::BlockingQueue<int>{};
+ *     auto value = queue.pop_front<ltb::util::ManualClock>(1s); // Waits until another thread
+ *                                                               // pushes or advances the clock.
+ */
+using SteadyClock = std::chrono::steady_clock;
+
+/// \brief `CLOCK_MONOTONIC_COARSE` on Linux. Reading it costs a few nanoseconds (no hardware
+///        counter is read) but it only advances once per scheduler tick (1-4ms). Use it for
+///        timestamps where millisecond precision is enough. Falls back to steady_clock elsewhere.
+class CoarseClock {
+public:
+    using duration   = Duration;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<CoarseClock>;
+
+    static constexpr bool is_steady = true;
+
+    static auto now() noexcept -> time_point;
+
+    /// \brief How far the clock jumps each time it advances.
+    static auto resolution() -> Duration;
+};
+
+/**
+ * @brief A process-wide clock that starts at zero and only moves when `advance` is called.
+ *
+ * Code templated on a clock can be tested without sleeping:
+ *
+ *     auto timer = ltb::util::BasicTimer<ltb::util::ManualClock>();
+ *     ltb::util::ManualClock::advance(250ms);
+ *     CHECK(timer.elapsed() == 250ms);
+ *
+ * `sleep_until` and `sleep_for` block until another thread advances the clock past the deadline.
+ * Timed waits inside the library (`BlockingQueue::pop_front`, `AtomicData::wait_to_use_safely`,
+ * ...) notice the clock moving within about a millisecond of real time.
+ */
+class ManualClock {
+public:
+    using duration   = Duration;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<ManualClock>;
+
+    static constexpr bool is_steady = true;
+
+    static auto now() noexcept -> time_point;
+
+    /// \brief Move the clock forward and wake any threads sleeping on it.
+    /// \throws std::invalid_argument if `amount` is negative.
+    static auto advance(Duration amount) -> void;
+
+    static auto sleep_until(time_point deadline) -> void;
+    static auto sleep_for(Duration amount) -> void;
+
+    /// \brief The number of threads currently blocked until the clock reaches a deadline. Tests
+    ///        can wait for their waiters to show up here before advancing the clock, so no waiter
+    ///        computes its deadline after the clock has already moved.
+    static auto waiting_threads() -> std::uint32_t;
+};
+
+namespace detail {
+
+/// \brief Counted by `ManualClock::waiting_threads` for as long as it exists.
+class ManualClockWaiter {
+public:
+    ManualClockWaiter();
+    ~ManualClockWaiter();
+
+    ManualClockWaiter(ManualClockWaiter const&) = delete;
+    ManualClockWaiter(ManualClockWaiter&&)      = delete;
+    auto operator=(ManualClockWaiter const&) -> ManualClockWaiter& = delete;
+    auto operator=(ManualClockWaiter&&) -> ManualClockWaiter& = delete;
+};
+
+} // namespace detail
+
+/// \brief How the library waits on a clock. Specialize this for clocks that are
+///        not driven by real time.
+template <typename Clock>
+struct ClockTraits {
+    /// \brief False if the clock doesn't advance with real time, so it can't be spun on.
+    static constexpr bool follows_real_time = true;
+
+    /// \brief Wait on `condition` until `predicate` is true or the deadline passes.
+    /// \return The final value of `predicate`.
+    template <typename Pred>
+    static auto wait_until(std::condition_variable&          condition,
+                           std::unique_lock<std::mutex>&     lock,
+                           typename Clock::time_point const& deadline,
+                           Pred                              predicate) -> bool {
+        return condition.wait_until(lock, deadline, std::move(predicate));
+    }
+
+    static auto sleep_until(typename Clock::time_point const& deadline) -> void {
+        std::this_thread::sleep_until(deadline);
+    }
+};
+
+template <>
+struct ClockTraits<ManualClock> {
+    static constexpr bool follows_real_time = false;
+
+    /// \brief Nothing notifies `condition` when the clock moves so it is re-checked every millisecond.
+    template <typename Pred>
+    static auto wait_until(std::condition_variable&       condition,
+                           std::unique_lock<std::mutex>&  lock,
+                           ManualClock::time_point const& deadline,
+                           Pred                           predicate) -> bool {
+        auto const waiter = detail::ManualClockWaiter{};
+        while (!predicate()) {
+            if (ManualClock::now() >= deadline) {
+                return predicate();
+            }
+            condition.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    static auto sleep_until(ManualClock::time_point const& deadline) -> void { ManualClock::sleep_until(deadline); }
+};
+
+/// \brief Block the calling thread until `Clock` reaches `deadline`.
+template <typename Clock, typename ClockDuration>
+auto sleep_until(std::chrono::time_point<Clock, ClockDuration> const& deadline) -> void {
+    ClockTraits<Clock>::sleep_until(std::chrono::time_point_cast<typename Clock::duration>(deadline));
+}
+
+/// \brief Block the calling thread until `amount` has passed on `Clock`.
+template <typename Clock = SteadyClock, typename Rep, typename Period>
+auto sleep_for(std::chrono::duration<Rep, Period> const& amount) -> void {
+    sleep_until(Clock::now() + std::chrono::duration_cast<typename Clock::duration>(amount));
+}
+
+} // namespace ltb::util
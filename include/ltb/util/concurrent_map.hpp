@@ -0,0 +1,239 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "cpu.hpp"
+
+// standard
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ltb::util {
+
+/**
+ * @brief A hash map split into independently locked stripes so threads working
+ *        on different keys rarely wait for each other.
+ *
+ * Each stripe is an `std::unordered_map` guarded by its own mutex and kept on its
+ * own cache line. Any hash that works with `std::unordered_map` works here,
+ * including `hash_combine` based hashes and `std::hash<ltb::util::Uuid<T>>`.
+ *
+ * Example:
+ *
+ *     ltb::util::ConcurrentMap<std::string, Mesh> mesh_cache;
+ *
+ *     ... Later, in different threads
+ *
+ *     Mesh mesh = mesh_cache.compute_if_absent(path, [&] { return load_mesh(path); });
+ *
+ * @tparam StripeCount the number of independently locked sub-maps (must be a power of 2).
+ */
+template <typename Key,
+          typename Value,
+          typename Hash           = std::hash<Key>,
+          typename KeyEqual       = std::equal_to<Key>,
+          std::size_t StripeCount = 16u>
+class ConcurrentMap {
+public:
+    static_assert(StripeCount > 0u && (StripeCount & (StripeCount - 1u)) == 0u, "StripeCount must be a power of 2");
+
+    explicit ConcurrentMap(Hash hash = Hash{}, KeyEqual key_equal = KeyEqual{});
+
+    /// \return a copy of the value stored at `key` or std::nullopt if there isn't one.
+    [[nodiscard]] auto find(Key const& key) const -> std::optional<Value>;
+
+    [[nodiscard]] auto contains(Key const& key) const -> bool;
+
+    /// \brief Insert `value` at `key` or replace the existing value.
+    /// \return true if the value was inserted, false if it was assigned.
+    auto insert_or_assign(Key key, Value value) -> bool;
+
+    /// \return true if a value was removed.
+    auto erase(Key const& key) -> bool;
+
+    /// \brief Return the value stored at `key`, inserting the result of `make_value()` first if
+    ///        there isn't one. `make_value` is called at most once per key and while the key's
+    ///        stripe is locked, so it should not access this map.
+    template <typename MakeValue>
+    auto compute_if_absent(Key const& key, MakeValue make_value) -> Value;
+
+    /// \brief Call `func(Key const&, Value&)` on every element. Stripes are processed in
+    ///        parallel on up to `max_threads` threads so `func` must be thread safe.
+    ///        Each stripe is locked while it is being processed.
+    template <typename Func>
+    auto for_each(Func func, std::size_t max_threads = std::thread::hardware_concurrency()) -> void;
+
+    /// \brief The total number of elements. Other threads may change this while it is being computed.
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    auto clear() -> void;
+
+private:
+    struct alignas(cache_line_size) Stripe {
+        mutable std::mutex                             mutex;
+        std::unordered_map<Key, Value, Hash, KeyEqual> map;
+    };
+
+    Hash                            hash_;
+    KeyEqual                        key_equal_;
+    std::array<Stripe, StripeCount> stripes_;
+
+    auto stripe_for(Key const& key) -> Stripe&;
+    auto stripe_for(Key const& key) const -> Stripe const&;
+};
+
+namespace detail {
+
+constexpr auto log2_of_power_of_2(std::size_t value) -> std::uint32_t {
+    auto bits = std::uint32_t{0u};
+    while (value > 1u) {
+        value >>= 1u;
+        ++bits;
+    }
+    return bits;
+}
+
+/// \brief Spread the bits of a hash with Fibonacci hashing and take the top `Bits` bits.
+///        This keeps the stripe choice independent of the bucket choice inside each stripe.
+template <std::uint32_t Bits>
+constexpr auto top_hash_bits(std::size_t hash) -> std::size_t {
+    if constexpr (Bits == 0u) {
+        return 0u;
+    } else {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ull) >> (64u - Bits));
+    }
+}
+
+} // namespace detail
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::ConcurrentMap(Hash hash, KeyEqual key_equal)
+    : hash_(std::move(hash)), key_equal_(std::move(key_equal)) {
+    for (auto& stripe : stripes_) {
+        stripe.map = std::unordered_map<Key, Value, Hash, KeyEqual>(0u, hash_, key_equal_);
+    }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::find(Key const& key) const -> std::optional<Value> {
+    auto const& stripe = stripe_for(key);
+    auto const  lock   = std::lock_guard(stripe.mutex);
+
+    auto iter = stripe.map.find(key);
+    if (iter == stripe.map.end()) {
+        return std::nullopt;
+    }
+    return iter->second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::contains(Key const& key) const -> bool {
+    auto const& stripe = stripe_for(key);
+    auto const  lock   = std::lock_guard(stripe.mutex);
+    return stripe.map.find(key) != stripe.map.end();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::insert_or_assign(Key key, Value value) -> bool {
+    auto&      stripe = stripe_for(key);
+    auto const lock   = std::lock_guard(stripe.mutex);
+    return stripe.map.insert_or_assign(std::move(key), std::move(value)).second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::erase(Key const& key) -> bool {
+    auto&      stripe = stripe_for(key);
+    auto const lock   = std::lock_guard(stripe.mutex);
+    return stripe.map.erase(key) > 0u;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+template <typename MakeValue>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::compute_if_absent(Key const& key, MakeValue make_value)
+    -> Value {
+    auto&      stripe = stripe_for(key);
+    auto const lock   = std::lock_guard(stripe.mutex);
+
+    auto iter = stripe.map.find(key);
+    if (iter == stripe.map.end()) {
+        iter = stripe.map.emplace(key, make_value()).first;
+    }
+    return iter->second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+template <typename Func>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::for_each(Func func, std::size_t max_threads) -> void {
+    auto next_stripe = std::atomic_size_t{0u};
+
+    auto process_stripes = [this, &func, &next_stripe] {
+        for (auto s = next_stripe++; s < StripeCount; s = next_stripe++) {
+            auto&      stripe = stripes_[s];
+            auto const lock   = std::lock_guard(stripe.mutex);
+            for (auto& [key, value] : stripe.map) {
+                func(key, value);
+            }
+        }
+    };
+
+    // The calling thread does its share of the work so only spawn the extra threads.
+    auto const thread_count = std::clamp(max_threads, std::size_t{1u}, StripeCount);
+
+    auto workers = std::vector<std::future<void>>{};
+    workers.reserve(thread_count - 1u);
+    for (auto t = 1u; t < thread_count; ++t) {
+        workers.emplace_back(std::async(std::launch::async, process_stripes));
+    }
+    process_stripes();
+
+    // Re-throws any exception thrown by `func` on another thread.
+    for (auto& worker : workers) {
+        worker.get();
+    }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::size() const -> std::size_t {
+    auto total = std::size_t{0u};
+    for (auto const& stripe : stripes_) {
+        auto const lock = std::lock_guard(stripe.mutex);
+        total += stripe.map.size();
+    }
+    return total;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::clear() -> void {
+    for (auto& stripe : stripes_) {
+        auto map_to_delete = std::unordered_map<Key, Value, Hash, KeyEqual>(0u, hash_, key_equal_);
+        {
+            auto const lock = std::lock_guard(stripe.mutex);
+            map_to_delete.swap(stripe.map);
+        }
+        // Values are destroyed outside the lock in case their destructors access this map.
+    }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::stripe_for(Key const& key) -> Stripe& {
+    return stripes_[detail::top_hash_bits<detail::log2_of_power_of_2(StripeCount)>(hash_(key))];
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, std::size_t StripeCount>
+auto ConcurrentMap<Key, Value, Hash, KeyEqual, StripeCount>::stripe_for(Key const& key) const -> Stripe const& {
+    return stripes_[detail::top_hash_bits<detail::log2_of_power_of_2(StripeCount)>(hash_(key))];
+}
+
+} // namespace ltb::util
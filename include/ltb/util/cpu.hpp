@@ -0,0 +1,33 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LTB_X86
+#include <immintrin.h>
+#endif
+
+// standard
+#include <cstddef>
+
+namespace ltb::util {
+
+/// \brief The alignment used to keep data written by different threads on separate cache lines.
+#if defined(__APPLE__) && defined(__aarch64__)
+constexpr auto cache_line_size = std::size_t{128};
+#else
+constexpr auto cache_line_size = std::size_t{64};
+#endif
+
+/// \brief Tell the processor the calling thread is spin-waiting so it can
+///        save power and yield pipeline resources to its sibling hyper-thread.
+inline auto cpu_relax() -> void {
+#if defined(LTB_X86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+} // namespace ltb::util
@@ -3,9 +3,15 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// project
+#include "stack_trace.hpp"
+
 // standard
-#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 
 ///\brief Macro used to auto-fill line and file information when creating an error.
 ///
@@ -24,49 +30,71 @@
 
 namespace ltb::util {
 
+/// \brief Where an error was created. `filename` must outlive the error (`__FILE__` always does).
 struct SourceLocation {
-    std::filesystem::path filename;
-    int                   line_number;
+    char const* filename;
+    int         line_number;
 
     SourceLocation() = delete;
-    SourceLocation(std::filesystem::path file, int line);
+    constexpr SourceLocation(char const* file, int line) : filename(file), line_number(line) {}
 };
 
 ///\brief A simple class used to pass error messages around.
+///
+/// Errors are created on every failure path so they are kept small and cheap to move: the
+/// source location is a pointer and a line number, messages up to `inline_message_capacity`
+/// characters are stored in the error itself, and the debug message is only built when asked for.
+///
+/// If `error_stack_traces_enabled()` is true when an error is created, the return addresses of
+/// the creating thread's stack are captured too. They are only symbolized in `debug_error_message()`,
+/// and copies of the error (and errors made with `append_message`) share the same trace.
 class Error {
 public:
-    enum class Severity {
+    enum class Severity : std::uint8_t {
         Error,
         Warning,
     };
 
+    static constexpr auto inline_message_capacity = std::size_t{24};
+
     Error() = delete;
-    explicit Error(SourceLocation source_location, Severity severity, std::string error_message);
-    virtual ~Error();
+    explicit Error(SourceLocation source_location, Severity severity, std::string_view error_message);
+    ~Error();
 
-    // default copy
-    Error(Error const&) = default;
-    auto operator=(Error const&) -> Error& = default;
+    Error(Error const& other);
+    auto operator=(Error const& other) -> Error&;
 
-    // default move
-    Error(Error&&) noexcept = default;
-    auto operator=(Error&&) noexcept -> Error& = default;
+    Error(Error&& other) noexcept;
+    auto operator=(Error&& other) noexcept -> Error&;
 
     [[nodiscard]] auto severity() const -> Severity const&;
-    [[nodiscard]] auto error_message() const -> std::string const&;
-    [[nodiscard]] auto debug_error_message() const -> std::string const&;
+    [[nodiscard]] auto error_message() const -> std::string_view;
+    /// \brief The error message with the line number, "[:line] error message", followed by the stack
+    ///        trace if there is one. Built on each call.
+    [[nodiscard]] auto debug_error_message() const -> std::string;
     [[nodiscard]] auto source_location() const -> SourceLocation const&;
+    /// \brief Where the error was created from, or null if stack traces were disabled.
+    [[nodiscard]] auto stack_trace() const -> StackTrace const*;
 
-    static auto append_message(Error const& error, std::string const& message) -> Error;
+    static auto append_message(Error const& error, std::string_view message) -> Error;
 
     auto operator==(Error const& other) const -> bool;
     auto operator!=(Error const& other) const -> bool;
 
 private:
-    SourceLocation source_location_; ///< File and line number where error was created
-    Severity       severity_; ///< The type of error (warning or error)
-    std::string    error_message_; ///< The error message
-    std::string    debug_message_; ///< Error message with file and line number "[file:line] error message"
+    SourceLocation                    source_location_; ///< File and line number where error was created
+    Severity                          severity_; ///< The type of error (warning or error)
+    std::uint32_t                     message_size_; ///< Length of the error message
+    std::shared_ptr<StackTrace const> stack_trace_; ///< Only set if stack traces are enabled
+    union {
+        char  inline_message_[inline_message_capacity]; ///< Used if the message fits
+        char* heap_message_; ///< Used otherwise
+    };
+
+    [[nodiscard]] auto is_inline() const -> bool;
+    [[nodiscard]] auto message_data() const -> char const*;
+    auto               assign_message(std::string_view message) -> void;
+    auto               release_message() -> void;
 };
 
 /// \brief An error with extra data pertaining to a specific type of error.
@@ -76,8 +104,8 @@ struct ContextError {
     Context context;
 
     [[nodiscard]] auto severity() const -> Error::Severity const& { return error.severity(); }
-    [[nodiscard]] auto error_message() const -> std::string const& { return error.error_message(); }
-    [[nodiscard]] auto debug_error_message() const -> std::string const& { return error.debug_error_message(); }
+    [[nodiscard]] auto error_message() const -> std::string_view { return error.error_message(); }
+    [[nodiscard]] auto debug_error_message() const -> std::string { return error.debug_error_message(); }
     [[nodiscard]] auto source_location() const -> SourceLocation const& { return error.source_location(); }
 
     ContextError(Error err, Context ctx) : error(std::move(err)), context(std::move(ctx)) {}
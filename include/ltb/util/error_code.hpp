@@ -0,0 +1,93 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "error.hpp"
+
+// standard
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+///\brief Macro used to turn an error code into a full `Error` with line and file information.
+///
+/// \code
+/// ltb::util::Error error = LTB_MAKE_ERROR_FROM_CODE(ParseError::Empty);
+/// assert(error.error_message() == error_code_message(ParseError::Empty));
+/// \endcode
+#define LTB_MAKE_ERROR_FROM_CODE(code) ::ltb::util::to_error({__FILE__, __LINE__}, ::ltb::util::ErrorCode(code))
+
+namespace ltb::util {
+
+/**
+ * @brief A register-sized error for failures too frequent to build an `Error` for.
+ *
+ * Wraps an enum with a static message for each value. The messages come from an
+ * `error_code_message` function declared next to the enum (found by argument-dependent
+ * lookup). Nothing is allocated until the code is turned into an `Error`, usually
+ * only when it is logged.
+ *
+ * Example:
+ *
+ *     enum class ParseError : std::uint8_t { Empty, NotANumber };
+ *
+ *     constexpr auto error_code_message(ParseError code) -> char const* {
+ *         switch (code) {
+ *             case ParseError::Empty: return "Input is empty";
+ *             case ParseError::NotANumber: return "Input is not a number";
+ *         }
+ *         return "Unknown parse error";
+ *     }
+ *
+ *     auto parse(std::string_view input) -> ltb::util::Result<int, ltb::util::ErrorCode<ParseError>> {
+ *         if (input.empty()) {
+ *             return tl::make_unexpected(ParseError::Empty);
+ *         }
+ *         ...
+ *     }
+ *
+ *     parse(input).map_error([](auto code) { log(LTB_MAKE_ERROR_FROM_CODE(code)); });
+ */
+template <typename Enum>
+class ErrorCode {
+public:
+    static_assert(std::is_enum_v<Enum>, "Error codes must be enums");
+
+    // Implicit so `tl::make_unexpected(enum_value)` converts to a `Result` with an `ErrorCode`.
+    constexpr ErrorCode(Enum code) noexcept : code_(code) {} // NOLINT(google-explicit-constructor)
+
+    [[nodiscard]] constexpr auto code() const noexcept -> Enum { return code_; }
+    [[nodiscard]] constexpr auto value() const noexcept -> std::underlying_type_t<Enum> {
+        return static_cast<std::underlying_type_t<Enum>>(code_);
+    }
+
+    [[nodiscard]] constexpr auto severity() const noexcept -> Error::Severity { return Error::Severity::Error; }
+    [[nodiscard]] constexpr auto error_message() const -> std::string_view { return error_code_message(code_); }
+
+    /// \brief The message with the numeric code, "[code N] error message".
+    [[nodiscard]] auto debug_error_message() const -> std::string;
+
+    constexpr auto operator==(ErrorCode const& other) const noexcept -> bool { return code_ == other.code_; }
+    constexpr auto operator!=(ErrorCode const& other) const noexcept -> bool { return code_ != other.code_; }
+
+private:
+    Enum code_;
+};
+
+/// \brief Convert an error code to a full `Error`, usually via `LTB_MAKE_ERROR_FROM_CODE`.
+template <typename Enum>
+auto to_error(SourceLocation source_location, ErrorCode<Enum> code, Error::Severity severity = Error::Severity::Error)
+    -> Error {
+    return Error(source_location, severity, code.error_message());
+}
+
+template <typename Enum>
+auto ErrorCode<Enum>::debug_error_message() const -> std::string {
+    auto result = "[code " + std::to_string(+value()) + "] ";
+    result += error_message();
+    return result;
+}
+
+} // namespace ltb::util
@@ -0,0 +1,90 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+#include "error.hpp"
+#include "error_callback.hpp"
+#include "ring_buffer.hpp"
+
+// standard
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace ltb::util {
+
+/**
+ * @brief Collapses bursts of the same error into a few samples and a count.
+ *
+ * Errors are grouped by where they were created (file and line) and their severity. In each
+ * `report_interval` the first `max_samples` errors of a group are passed on to `downstream`
+ * and the rest are only counted. At the end of the interval, a group that had more sends one
+ * more error saying how many were left out.
+ *
+ * Reporting threads only push the error to a lock-free ring buffer, so they never block.
+ * Grouping and calls to `downstream` happen on the sink's background thread. If the buffer
+ * fills up, errors are dropped and counted instead.
+ *
+ * Example:
+ *
+ *     auto sink = ltb::util::AggregatingErrorSink([](ltb::util::Error error) { log(error.debug_error_message()); });
+ *
+ *     auto task_runner = ltb::util::AsyncTaskRunner<Data>{};
+ *     task_runner.schedule_task(fetch_data, use_data, sink.callback());
+ */
+class AggregatingErrorSink {
+public:
+    /// \param downstream - receives the samples and summaries. Called on the sink's thread.
+    /// \param max_samples - the number of errors per group passed on in each interval.
+    /// \param capacity - the number of errors that can be queued before they are dropped.
+    /// \param report_interval - how often counts are summarized and reset.
+    explicit AggregatingErrorSink(ErrorCallback downstream,
+                                  std::size_t   max_samples     = 3u,
+                                  std::size_t   capacity        = 4096u,
+                                  Duration      report_interval = duration_seconds(1));
+
+    /// \brief Reports anything still queued or counted.
+    ~AggregatingErrorSink();
+
+    AggregatingErrorSink(AggregatingErrorSink const&)                    = delete;
+    auto operator=(AggregatingErrorSink const&) -> AggregatingErrorSink& = delete;
+
+    /// \brief Safe to call from any thread. Never blocks.
+    auto submit(Error error) -> void;
+
+    /// \brief A callback that submits errors to this sink. The sink must outlive it.
+    [[nodiscard]] auto callback() -> ErrorCallback;
+
+    /// \brief Block until every error submitted before this call has been passed on or
+    ///        summarized, ending the current interval early.
+    auto flush() -> void;
+
+    /// \brief The number of errors dropped because the buffer was full.
+    [[nodiscard]] auto dropped() const -> std::uint64_t;
+
+private:
+    ErrorCallback                        downstream_;
+    std::size_t                          max_samples_;
+    Duration                             report_interval_;
+    MpscRingBuffer<std::optional<Error>> errors_;
+    std::atomic<std::uint64_t>           dropped_ = {0u};
+
+    std::mutex              mutex_;
+    std::condition_variable wake_reporter_;
+    std::condition_variable flushed_;
+    std::uint64_t           flushes_requested_ = 0u; ///< Guarded by `mutex_`
+    std::uint64_t           flushes_completed_ = 0u; ///< Guarded by `mutex_`
+    bool                    stopping_          = false; ///< Guarded by `mutex_`
+
+    std::thread reporter_thread_;
+
+    auto report_loop() -> void;
+};
+
+} // namespace ltb::util
@@ -0,0 +1,244 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "benchmark.hpp"
+#include "duration.hpp"
+#include "latency_histogram.hpp"
+#include "tsc_clock.hpp"
+
+// standard
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ltb::util {
+
+/// \brief One point in a producer/consumer sweep.
+struct HandoffConfig {
+    std::uint32_t producers             = 1u;
+    std::uint32_t consumers             = 1u;
+    std::size_t   payload_bytes         = 8u;
+    std::uint32_t burst_size            = 1u; ///< Messages sent back to back before pausing
+    Duration      burst_pause           = {}; ///< How long producers pause between bursts
+    std::uint64_t messages_per_producer = 10'000u;
+};
+
+/// \brief Throughput and latency of one `HandoffConfig`.
+struct HandoffResult {
+    std::string   name;
+    HandoffConfig config;
+    std::uint64_t messages         = 0u;
+    double        ops_per_second   = 0.0;
+    Duration      p50_handoff      = {};
+    Duration      p99_handoff      = {};
+    Duration      max_handoff      = {};
+    double        cpu_nanos_per_op = 0.0; ///< Process CPU time (all threads) per message
+};
+
+/// \brief Payload sizes swept by `run_handoff_sweep`.
+constexpr auto handoff_payload_sizes = std::array<std::size_t, 3>{8u, 128u, 2048u};
+
+/// \brief What producers send to consumers. The payload is copied along with each message.
+template <std::size_t PayloadBytes>
+struct HandoffMessage {
+    std::int64_t                           sent_nanos = 0; ///< Negative values tell consumers to stop
+    std::array<std::uint8_t, PayloadBytes> payload    = {};
+};
+
+/// \brief CPU time used by every thread in the process.
+auto process_cpu_time() -> Duration;
+
+/**
+ * @brief Start `config.producers` threads that each `push` messages and `config.consumers`
+ *        threads that each `pop` messages until they receive a stop message.
+ *
+ * `push(Message)` may be called concurrently from every producer and `pop() -> Message`
+ * from every consumer. `pop` should block until a message is available.
+ *
+ * Example:
+ *
+ *     auto queue  = ltb::util::BlockingQueue<Message>{};
+ *     auto result = ltb::util::run_handoff<Message>(
+ *         "blocking_queue",
+ *         config,
+ *         [&queue](Message message) { queue.push_back(std::move(message)); },
+ *         [&queue] { return queue.pop_front(); });
+ */
+template <typename Message, typename Push, typename Pop>
+auto run_handoff(std::string name, HandoffConfig const& config, Push push, Pop pop) -> HandoffResult;
+
+/// \brief Call `func(std::integral_constant<std::size_t, N>{})` where `N == payload_bytes`.
+///        `payload_bytes` must be one of `handoff_payload_sizes`.
+template <typename Func>
+auto visit_handoff_payload(std::size_t payload_bytes, Func func) -> HandoffResult;
+
+using HandoffFunction = std::function<HandoffResult(HandoffConfig const&)>;
+
+struct HandoffSweepOptions {
+    std::uint32_t max_threads           = std::max(std::thread::hardware_concurrency(), 1u);
+    std::uint64_t messages_per_producer = 10'000u;
+    std::string   filter                = {}; ///< Only run handoffs whose names contain this string
+};
+
+/// \brief Add a channel to be swept by `run_handoff_sweep`. Prefer the `LTB_HANDOFF_BENCHMARK` macro.
+auto register_handoff_benchmark(std::string name, HandoffFunction function) -> bool;
+
+/// \brief Producer and consumer counts used for a sweep: 1, 2, 4, ... up to and including `max_threads`.
+auto handoff_thread_counts(std::uint32_t max_threads) -> std::vector<std::uint32_t>;
+
+/// \brief Run every registered channel for all combinations of thread counts, payload sizes,
+///        and burst patterns, writing each result to `csv` as it finishes.
+auto run_handoff_sweep(HandoffSweepOptions const& options, std::ostream& csv) -> std::vector<HandoffResult>;
+
+auto write_handoff_csv_header(std::ostream& os) -> void;
+auto write_handoff_csv_row(std::ostream& os, HandoffResult const& result) -> void;
+
+/// \brief Parses `--filter <str>`, `--max-threads <n>`, `--messages <n>` and `--csv <file>`
+///        then runs the sweep. The CSV is written to stdout if no file is given. Returns an exit code.
+auto handoff_sweep_main(int argc, char const* const* argv) -> int;
+
+namespace detail {
+
+/// \brief Spins until every thread has arrived.
+class StartLine {
+public:
+    explicit StartLine(std::uint32_t thread_count) : waiting_(thread_count) {}
+
+    auto arrive_and_wait() -> void {
+        waiting_.fetch_sub(1u, std::memory_order_acq_rel);
+        while (waiting_.load(std::memory_order_acquire) > 0u) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    std::atomic<std::uint32_t> waiting_;
+};
+
+inline auto handoff_now_nanos() -> std::int64_t {
+    return to_nanos<std::int64_t>(TscClock::now().time_since_epoch());
+}
+
+template <std::size_t Index = 0u, typename Func>
+auto visit_handoff_payload(std::size_t payload_bytes, Func& func) -> HandoffResult {
+    if constexpr (Index == handoff_payload_sizes.size()) {
+        throw std::invalid_argument("Unsupported handoff payload size: " + std::to_string(payload_bytes));
+    } else {
+        if (payload_bytes == handoff_payload_sizes[Index]) {
+            return func(std::integral_constant<std::size_t, handoff_payload_sizes[Index]>{});
+        }
+        return visit_handoff_payload<Index + 1u>(payload_bytes, func);
+    }
+}
+
+} // namespace detail
+
+template <typename Message, typename Push, typename Pop>
+auto run_handoff(std::string name, HandoffConfig const& config, Push push, Pop pop) -> HandoffResult {
+    auto const producers = std::max(config.producers, 1u);
+    auto const consumers = std::max(config.consumers, 1u);
+    auto const burst     = std::max(config.burst_size, 1u);
+
+    // One histogram per consumer so recording doesn't contend.
+    auto histograms = std::vector<std::unique_ptr<LatencyHistogram>>{};
+    for (auto i = 0u; i < consumers; ++i) {
+        histograms.emplace_back(std::make_unique<LatencyHistogram>());
+    }
+
+    auto start_line = detail::StartLine(producers + consumers + 1u);
+    auto threads    = std::vector<std::thread>{};
+
+    for (auto i = 0u; i < consumers; ++i) {
+        threads.emplace_back([&pop, &start_line, &histogram = *histograms[i]] {
+            start_line.arrive_and_wait();
+            while (true) {
+                Message message = pop();
+                if (message.sent_nanos < 0) {
+                    break;
+                }
+                histogram.record(duration_nanos(detail::handoff_now_nanos() - message.sent_nanos));
+            }
+        });
+    }
+    for (auto i = 0u; i < producers; ++i) {
+        threads.emplace_back([&push, &start_line, &config, burst] {
+            start_line.arrive_and_wait();
+            auto message = Message{};
+            for (auto sent = std::uint64_t{0u}; sent < config.messages_per_producer; ++sent) {
+                if (sent > 0u && sent % burst == 0u && config.burst_pause > Duration::zero()) {
+                    std::this_thread::sleep_for(config.burst_pause);
+                }
+                message.payload[0] = static_cast<std::uint8_t>(sent);
+                message.sent_nanos = detail::handoff_now_nanos();
+                push(message);
+            }
+        });
+    }
+
+    start_line.arrive_and_wait();
+    auto const start_cpu  = process_cpu_time();
+    auto const start_wall = TscClock::now();
+
+    for (auto i = 0u; i < producers; ++i) {
+        threads[consumers + i].join();
+    }
+    for (auto i = 0u; i < consumers; ++i) {
+        auto stop       = Message{};
+        stop.sent_nanos = -1;
+        push(stop);
+    }
+    for (auto i = 0u; i < consumers; ++i) {
+        threads[i].join();
+    }
+
+    auto const wall = TscClock::now() - start_wall;
+    auto const cpu  = process_cpu_time() - start_cpu;
+
+    auto latencies = LatencyHistogram{};
+    for (auto const& histogram : histograms) {
+        latencies.merge(*histogram);
+    }
+
+    auto result     = HandoffResult{};
+    result.name     = std::move(name);
+    result.config   = config;
+    result.messages = latencies.count();
+
+    auto const messages     = static_cast<double>(std::max(result.messages, std::uint64_t{1u}));
+    result.ops_per_second   = messages / std::max(to_seconds<double>(wall), 1e-9);
+    result.p50_handoff      = latencies.percentile(50.0);
+    result.p99_handoff      = latencies.percentile(99.0);
+    result.max_handoff      = latencies.percentile(100.0);
+    result.cpu_nanos_per_op = to_nanos<double>(cpu) / messages;
+    return result;
+}
+
+template <typename Func>
+auto visit_handoff_payload(std::size_t payload_bytes, Func func) -> HandoffResult {
+    return detail::visit_handoff_payload(payload_bytes, func);
+}
+
+} // namespace ltb::util
+
+///\brief Define and register a channel for `run_handoff_sweep`. The body has access to
+///       `ltb::util::HandoffConfig const& config` and must return a `ltb::util::HandoffResult`.
+#define LTB_HANDOFF_BENCHMARK(name)                                                                                    \
+    static auto LTB_BENCHMARK_CONCAT(ltb_handoff_, __LINE__)(::ltb::util::HandoffConfig const& config)                 \
+        ->::ltb::util::HandoffResult;                                                                                  \
+    static auto const LTB_BENCHMARK_CONCAT(ltb_handoff_registered_, __LINE__)                                          \
+        = ::ltb::util::register_handoff_benchmark(name, &LTB_BENCHMARK_CONCAT(ltb_handoff_, __LINE__));                \
+    static auto LTB_BENCHMARK_CONCAT(ltb_handoff_, __LINE__)(::ltb::util::HandoffConfig const& config)                 \
+        ->::ltb::util::HandoffResult
@@ -0,0 +1,97 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+
+// standard
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace ltb::util {
+
+/**
+ * @brief Counts nanosecond durations in log-linear buckets so percentiles can be
+ *        reported over the full 64-bit range with a bounded relative error.
+ *
+ * Values below 128ns get their own bucket. Larger values are split into 64 linear
+ * buckets per power of 2, so a reported percentile is never more than 1/64 (~1.6%)
+ * above the true value. Memory use is fixed (~30KB) and recording is a handful of
+ * relaxed atomic increments, so any number of threads can record into the same
+ * histogram. For very hot paths, record into one histogram per thread and `merge`
+ * them when reporting.
+ *
+ * Example:
+ *
+ *     auto& frame_times = ltb::util::latency_histogram("frame");
+ *
+ *     while (running) {
+ *         auto timer = ltb::util::ScopedTimer(frame_times); // records instead of printing
+ *         ...
+ *     }
+ *
+ *     ltb::util::dump_latency_histograms(std::cout);
+ */
+class LatencyHistogram {
+public:
+    struct Summary {
+        std::uint64_t count = 0u;
+        Duration      total = {};
+        Duration      min   = {};
+        Duration      p50   = {};
+        Duration      p90   = {};
+        Duration      p99   = {};
+        Duration      p999  = {};
+        Duration      max   = {};
+    };
+
+    static constexpr auto sub_bucket_bits = 7u;
+    static constexpr auto bucket_count    = std::size_t{(64u - sub_bucket_bits + 2u) << (sub_bucket_bits - 1u)};
+
+    auto record(Duration duration) -> void;
+
+    /// \brief Add every value recorded by `other` to this histogram.
+    auto merge(LatencyHistogram const& other) -> void;
+
+    /// \brief Remove all recorded values. Values recorded concurrently may or may not be kept.
+    auto reset() -> void;
+
+    [[nodiscard]] auto count() const -> std::uint64_t;
+
+    /// \return The smallest recorded value that `percentile` percent of values are less than or
+    ///         equal to (within the bucket precision). Zero if nothing has been recorded.
+    [[nodiscard]] auto percentile(double percentile) const -> Duration;
+
+    [[nodiscard]] auto summary() const -> Summary;
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_ = {};
+    std::atomic<std::uint64_t>                           count_   = {0u};
+    std::atomic<std::uint64_t>                           total_   = {0u};
+    std::atomic<std::uint64_t>                           min_     = {~std::uint64_t{0u}};
+    std::atomic<std::uint64_t>                           max_     = {0u};
+};
+
+/// \brief Get the histogram for `name`, creating it if it doesn't exist yet.
+///        The returned reference stays valid for the life of the program.
+auto latency_histogram(std::string const& name) -> LatencyHistogram&;
+
+/// \brief Write a table summarizing every named histogram to `os`. The stream's formatting is left unchanged.
+auto dump_latency_histograms(std::ostream& os) -> void;
+
+namespace detail {
+
+/// \brief The index of the bucket containing `nanos`.
+auto latency_bucket_index(std::uint64_t nanos) -> std::size_t;
+
+/// \brief The largest value that is counted in the bucket at `index`.
+auto latency_bucket_upper_bound(std::size_t index) -> std::uint64_t;
+
+} // namespace detail
+
+} // namespace ltb::util
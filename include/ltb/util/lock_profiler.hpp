@@ -0,0 +1,76 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+#include "latency_histogram.hpp"
+
+// standard
+#include <chrono>
+#include <iosfwd>
+#include <string>
+
+namespace ltb::util {
+
+#ifdef LTB_PROFILE_LOCKS
+constexpr auto lock_profiling_enabled = true;
+#else
+constexpr auto lock_profiling_enabled = false;
+#endif
+
+/// \brief Lock wait and hold times for every AtomicData sharing the same name.
+///
+/// Recording only happens when the library is built with `LTB_PROFILE_LOCKS`
+/// defined (the `LTB_PROFILE_LOCKS` CMake option). Otherwise AtomicData doesn't
+/// reference this class at all.
+class LockProfile {
+public:
+    using Summary = LatencyHistogram::Summary;
+
+    explicit LockProfile(std::string name);
+
+    /// \brief Time spent blocked before the lock was acquired.
+    auto record_wait(Duration duration) -> void;
+
+    /// \brief Time spent with the lock held.
+    auto record_hold(Duration duration) -> void;
+
+    [[nodiscard]] auto name() const -> std::string const&;
+    [[nodiscard]] auto wait_summary() const -> Summary;
+    [[nodiscard]] auto hold_summary() const -> Summary;
+
+private:
+    std::string      name_;
+    LatencyHistogram waits_;
+    LatencyHistogram holds_;
+};
+
+/// \brief Get the profile for `name`, creating it if it doesn't exist yet.
+///        The returned reference stays valid for the life of the program.
+auto lock_profile(std::string const& name) -> LockProfile&;
+
+/// \brief Write a table of every lock profile to `os`. Intended to be called at shutdown.
+///        The stream's formatting is left unchanged.
+auto dump_lock_profiles(std::ostream& os) -> void;
+
+namespace detail {
+
+#ifdef LTB_PROFILE_LOCKS
+using LockTimestamp = std::chrono::steady_clock::time_point;
+
+inline auto lock_timestamp() -> LockTimestamp {
+    return std::chrono::steady_clock::now();
+}
+#else
+struct LockTimestamp {};
+
+inline auto lock_timestamp() -> LockTimestamp {
+    return {};
+}
+#endif
+
+} // namespace detail
+
+} // namespace ltb::util
@@ -0,0 +1,176 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "cpu.hpp"
+#include "result.hpp"
+
+// standard
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ltb::util {
+
+/// \brief Each metric is split into this many cache-line-sized shards. Threads are spread
+///        over the shards so updates from different threads (up to this many) never contend.
+constexpr auto metric_shard_count = std::size_t{64u};
+
+namespace detail {
+
+/// \brief The shard the calling thread updates. Assigned round-robin on first use.
+inline auto this_thread_metric_shard() -> std::size_t {
+    static auto             next_shard = std::atomic<std::size_t>{0u};
+    thread_local auto const shard      = next_shard.fetch_add(1u, std::memory_order_relaxed) % metric_shard_count;
+    return shard;
+}
+
+template <typename T>
+struct alignas(cache_line_size) MetricShard {
+    std::atomic<T> value = {T{}};
+};
+
+/// \brief One cache line of histogram bucket counts. Lines are never shared between shards.
+struct alignas(cache_line_size) MetricCountLine {
+    static constexpr auto size = cache_line_size / sizeof(std::atomic<std::uint64_t>);
+
+    std::array<std::atomic<std::uint64_t>, size> counts = {};
+};
+
+} // namespace detail
+
+/// \brief A value that only goes up, like the number of tasks run.
+class Counter {
+public:
+    /// \brief A single uncontended relaxed add to the calling thread's shard.
+    auto increment(std::uint64_t amount = 1u) -> void {
+        shards_[detail::this_thread_metric_shard()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    /// \brief The sum over all shards.
+    [[nodiscard]] auto value() const -> std::uint64_t;
+
+private:
+    std::array<detail::MetricShard<std::uint64_t>, metric_shard_count> shards_ = {};
+};
+
+/// \brief A value that can go up and down, like a queue depth.
+class Gauge {
+public:
+    /// \brief A single uncontended relaxed add to the calling thread's shard.
+    auto add(std::int64_t amount) -> void {
+        shards_[detail::this_thread_metric_shard()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    auto subtract(std::int64_t amount) -> void { add(-amount); }
+
+    /// \brief Replace the value. This reads every shard so it is slower than `add`, and
+    ///        concurrent adds may or may not be included in the new value.
+    auto set(std::int64_t value) -> void;
+
+    [[nodiscard]] auto value() const -> std::int64_t;
+
+private:
+    std::array<detail::MetricShard<std::int64_t>, metric_shard_count> shards_ = {};
+};
+
+/// \brief Counts observations (like latencies in seconds) in buckets with fixed upper bounds.
+class Histogram {
+public:
+    struct Snapshot {
+        std::vector<double>        upper_bounds;
+        std::vector<std::uint64_t> cumulative_counts; ///< One per bound plus a final +Inf bucket
+        std::uint64_t              count = 0u;
+        double                     sum   = 0.0;
+    };
+
+    /// \param upper_bounds - sorted bucket boundaries. Values above the last go in a +Inf bucket.
+    explicit Histogram(std::vector<double> upper_bounds);
+
+    /// \brief Uncontended relaxed adds to the calling thread's shard.
+    auto observe(double value) -> void;
+
+    [[nodiscard]] auto snapshot() const -> Snapshot;
+
+private:
+    std::vector<double> upper_bounds_;
+    std::size_t         lines_per_shard_;
+
+    /// \brief Every shard's counts in one allocation, each shard starting on its own cache line.
+    std::unique_ptr<detail::MetricCountLine[]>                  count_lines_;
+    std::array<detail::MetricShard<double>, metric_shard_count> sums_ = {};
+
+    [[nodiscard]] auto count(std::size_t shard, std::size_t bucket) const -> std::atomic<std::uint64_t>&;
+};
+
+/// \brief Bucket bounds from 1 microsecond to 10 seconds for latencies measured in seconds.
+auto default_latency_buckets() -> std::vector<double>;
+
+/**
+ * @brief Owns named metrics and exports them in the Prometheus text format.
+ *
+ * Looking a metric up takes a lock so references should be kept and reused:
+ *
+ *     static auto& tasks_run   = ltb::util::metrics().counter("tasks_run_total", "Tasks run");
+ *     static auto& queue_depth = ltb::util::metrics().gauge("queue_depth", "Queued tasks", R"(queue="io")");
+ *
+ *     tasks_run.increment();
+ *     queue_depth.add(1);
+ *
+ *     ltb::util::metrics().write_prometheus(std::cout);
+ *
+ * Requesting an existing name with a different metric type throws `std::invalid_argument`.
+ */
+class MetricsRegistry {
+public:
+    /// \param labels - Prometheus labels without braces, for example `queue="io",priority="high"`
+    auto counter(std::string const& name, std::string const& help, std::string const& labels = "") -> Counter&;
+    auto gauge(std::string const& name, std::string const& help, std::string const& labels = "") -> Gauge&;
+
+    /// \param upper_bounds - only used the first time a histogram with `name` and `labels` is requested.
+    auto histogram(std::string const&  name,
+                   std::string const&  help,
+                   std::vector<double> upper_bounds = default_latency_buckets(),
+                   std::string const&  labels       = "") -> Histogram&;
+
+    /// \brief Write a snapshot of every metric in the Prometheus text exposition format.
+    auto write_prometheus(std::ostream& os) const -> void;
+    auto write_prometheus(std::filesystem::path const& filename) const -> Result<void>;
+
+    [[nodiscard]] auto to_prometheus_string() const -> std::string;
+
+private:
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    struct Family {
+        Type        type;
+        std::string help;
+        // Keyed by labels. Only one of the maps is used depending on the type.
+        std::map<std::string, std::unique_ptr<Counter>>   counters;
+        std::map<std::string, std::unique_ptr<Gauge>>     gauges;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    mutable std::mutex            mutex_;
+    std::map<std::string, Family> families_;
+
+    auto family(std::string const& name, std::string const& help, Type type) -> Family&;
+};
+
+/// \brief The registry shared by the whole program. It stays valid for the life of the program.
+auto metrics() -> MetricsRegistry&;
+
+} // namespace ltb::util
@@ -0,0 +1,125 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+
+// standard
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+
+namespace ltb::util {
+
+/// \brief Hardware events counted for the calling thread (user space only).
+struct HardwareCounts {
+    std::uint64_t cycles        = 0u;
+    std::uint64_t instructions  = 0u;
+    std::uint64_t cache_misses  = 0u; ///< Last level cache misses
+    std::uint64_t branch_misses = 0u;
+
+    /// \brief Instructions per cycle. Zero if no cycles were counted.
+    [[nodiscard]] auto ipc() const -> double;
+};
+
+auto operator-(HardwareCounts const& lhs, HardwareCounts const& rhs) -> HardwareCounts;
+
+/// \brief Unscaled counts since a counter group was opened, along with how long the group
+///        was enabled and how long it was actually counting. The two times differ when the
+///        kernel has to multiplex the counters.
+struct PerfCounterReading {
+    HardwareCounts raw          = {};
+    std::uint64_t  time_enabled = 0u; ///< Nanoseconds
+    std::uint64_t  time_running = 0u; ///< Nanoseconds
+};
+
+/// \brief The counts between two readings, scaled by the fraction of that interval the
+///        counters were running. Empty if they didn't run at all between the readings.
+auto counts_between(PerfCounterReading const& start, PerfCounterReading const& end) -> std::optional<HardwareCounts>;
+
+/**
+ * @brief A group of `perf_event_open` counters for one thread that are always read together.
+ *
+ * Opening the counters fails when the kernel doesn't permit it (see
+ * `/proc/sys/kernel/perf_event_paranoid`), in most virtual machines, and on platforms
+ * other than Linux. `read` then returns nothing so callers can fall back to timing only.
+ */
+class PerfCounterGroup {
+public:
+    /// \brief Opens and enables the counters for the calling thread.
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(PerfCounterGroup const&)                    = delete;
+    PerfCounterGroup(PerfCounterGroup&&)                         = delete;
+    auto operator=(PerfCounterGroup const&) -> PerfCounterGroup& = delete;
+    auto operator=(PerfCounterGroup&&) -> PerfCounterGroup&      = delete;
+
+    [[nodiscard]] auto available() const -> bool;
+
+    /// \return The unscaled counts since the group was opened, or nothing if they aren't
+    ///         available. Must be called on the opening thread. See `counts_between`.
+    [[nodiscard]] auto read() const -> std::optional<PerfCounterReading>;
+
+private:
+    std::array<int, 4> fds_ = {-1, -1, -1, -1}; ///< The first counter leads the group
+};
+
+/// \brief The counter group of the calling thread. It is opened on first use and reused after.
+auto this_thread_perf_counters() -> PerfCounterGroup&;
+
+/// \brief Wall time of a region and its hardware counts, if they were available.
+struct PerfCounters {
+    Duration                      wall     = {};
+    std::optional<HardwareCounts> hardware = {};
+};
+
+/// \brief Write the wall time, IPC, and cycles and misses per element (or just the wall time
+///        if hardware counters aren't available).
+auto write_perf_counters(std::ostream& os, PerfCounters const& counters, std::uint64_t elements) -> void;
+
+/// \brief Reads the calling thread's counters when started and when `elapsed` is called.
+///        Must be started and read on the same thread.
+class PerfTimer {
+public:
+    PerfTimer();
+
+    auto start() -> void;
+
+    [[nodiscard]] auto elapsed() const -> PerfCounters;
+
+private:
+    std::optional<PerfCounterReading>     start_reading_;
+    std::chrono::steady_clock::time_point start_wall_;
+};
+
+/**
+ * @brief Prints the wall time and hardware counts of a region when it goes out of scope.
+ *
+ * Example:
+ *
+ *     {
+ *         auto zone = ltb::util::ScopedPerfZone("sum", values.size());
+ *         sum = std::accumulate(values.begin(), values.end(), 0.0);
+ *     }
+ *     // "sum: 1.234567ms, IPC 2.51, 3.02 cycles/element, 0.0621 cache misses/element, ..."
+ */
+class ScopedPerfZone {
+public:
+    /// \param elements - the number of items processed in the zone. Counts are divided by this.
+    explicit ScopedPerfZone(std::string name, std::uint64_t elements = 1u, std::ostream& os = std::cout);
+    ~ScopedPerfZone();
+
+private:
+    std::string   name_;
+    std::uint64_t elements_;
+    std::ostream& ostream_;
+    PerfTimer     timer_;
+};
+
+} // namespace ltb::util
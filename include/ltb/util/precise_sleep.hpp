@@ -0,0 +1,186 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "clock.hpp"
+#include "cpu.hpp"
+#include "duration.hpp"
+
+// standard
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+namespace ltb::util {
+
+/**
+ * @brief Sleeps until a deadline with microsecond precision.
+ *
+ * The OS usually wakes a sleeping thread 50-100us (sometimes milliseconds) after it
+ * asked to be woken. This sleeps until `margin()` before the deadline and spins on
+ * `cpu_relax` for the rest. The margin tracks how late recent wake-ups were: a smoothed
+ * mean plus four times the smoothed deviation, the same estimator TCP uses for
+ * retransmission timeouts, so it shrinks on an idle machine and grows under load.
+ *
+ * Each sleeper learns separately so one is usually kept per thread (see `precise_sleep_until`).
+ */
+class PreciseSleeper {
+public:
+    /// \param max_spin - the longest the sleeper will spin for, however late wake-ups get.
+    explicit PreciseSleeper(Duration max_spin = duration_millis(2));
+
+    template <typename Clock, typename ClockDuration>
+    auto sleep_until(std::chrono::time_point<Clock, ClockDuration> const& deadline) -> void;
+
+    /// \brief How long before the deadline the sleeper stops sleeping and starts spinning.
+    [[nodiscard]] auto margin() const -> Duration;
+
+    /// \brief Update the estimate with how much later than requested a sleep returned.
+    auto record_oversleep(Duration oversleep) -> void;
+
+private:
+    Duration max_spin_;
+    double   mean_oversleep_nanos_;
+    double   oversleep_deviation_nanos_;
+};
+
+/// \brief The calling thread's sleeper.
+inline auto this_thread_sleeper() -> PreciseSleeper& {
+    thread_local auto sleeper = PreciseSleeper();
+    return sleeper;
+}
+
+/// \brief Sleep until `deadline` using the calling thread's `PreciseSleeper`.
+template <typename Clock, typename ClockDuration>
+auto precise_sleep_until(std::chrono::time_point<Clock, ClockDuration> const& deadline) -> void {
+    this_thread_sleeper().sleep_until(deadline);
+}
+
+template <typename Clock = SteadyClock>
+auto precise_sleep_for(Duration const& duration) -> void {
+    precise_sleep_until(Clock::now() + std::chrono::duration_cast<typename Clock::duration>(duration));
+}
+
+/**
+ * @brief Paces a fixed-rate loop and reports deadlines it missed.
+ *
+ * Tick deadlines sit on a fixed grid (`start + n * period`) so small delays don't
+ * accumulate. If the loop body overruns, the ticks it overran are skipped rather than
+ * run back to back, and the next tick starts immediately:
+ *
+ *     auto pacer = ltb::util::TickPacer(ltb::util::duration_millis(10));
+ *     while (running) {
+ *         auto const tick = pacer.wait_for_next_tick();
+ *         if (tick.missed > 0u) {
+ *             std::cerr << "Skipped " << tick.missed << " ticks\n";
+ *         }
+ *         update();
+ *     }
+ */
+template <typename Clock>
+class BasicTickPacer {
+public:
+    struct Tick {
+        std::uint64_t index    = 0u; ///< Counts from zero, including skipped ticks
+        std::uint64_t missed   = 0u; ///< Ticks skipped since the previous one
+        Duration      lateness = {}; ///< How long after its deadline this tick started
+    };
+
+    /// \brief The first tick is due one `period` after construction.
+    explicit BasicTickPacer(Duration period);
+
+    /// \brief Sleep until the next tick is due, or return immediately if it is overdue.
+    auto wait_for_next_tick() -> Tick;
+
+    /// \brief Start the grid again from now.
+    auto reset() -> void;
+
+    [[nodiscard]] auto period() const -> Duration;
+    [[nodiscard]] auto next_deadline() const -> typename Clock::time_point;
+    [[nodiscard]] auto missed_ticks() const -> std::uint64_t; ///< Total skipped since construction
+
+private:
+    typename Clock::duration   period_;
+    typename Clock::time_point next_deadline_;
+    std::uint64_t              next_index_   = 0u;
+    std::uint64_t              missed_ticks_ = 0u;
+    PreciseSleeper             sleeper_;
+};
+
+using TickPacer = BasicTickPacer<SteadyClock>;
+
+template <typename Clock, typename ClockDuration>
+auto PreciseSleeper::sleep_until(std::chrono::time_point<Clock, ClockDuration> const& deadline) -> void {
+    if constexpr (!ClockTraits<Clock>::follows_real_time) {
+        util::sleep_until(deadline);
+
+    } else {
+        auto const sleep_margin = std::chrono::duration_cast<typename Clock::duration>(margin());
+
+        for (auto now = Clock::now(); deadline - now > sleep_margin; now = Clock::now()) {
+            auto const requested = deadline - now - sleep_margin;
+            std::this_thread::sleep_for(requested);
+            record_oversleep(std::chrono::duration_cast<Duration>(Clock::now() - now - requested));
+        }
+
+        while (Clock::now() < deadline) {
+            cpu_relax();
+        }
+    }
+}
+
+template <typename Clock>
+BasicTickPacer<Clock>::BasicTickPacer(Duration period)
+    : period_(std::chrono::duration_cast<typename Clock::duration>(period)) {
+    if (period_ <= Clock::duration::zero()) {
+        throw std::invalid_argument("Tick period must be positive");
+    }
+    reset();
+}
+
+template <typename Clock>
+auto BasicTickPacer<Clock>::wait_for_next_tick() -> Tick {
+    auto tick = Tick{};
+
+    auto const now = Clock::now();
+    if (now > next_deadline_) {
+        // Skip to the most recent deadline instead of running every overdue tick back to back.
+        tick.missed = static_cast<std::uint64_t>((now - next_deadline_) / period_);
+        next_deadline_ += period_ * static_cast<typename Clock::rep>(tick.missed);
+        next_index_ += tick.missed;
+        missed_ticks_ += tick.missed;
+    } else {
+        sleeper_.sleep_until(next_deadline_);
+    }
+
+    tick.index    = next_index_++;
+    tick.lateness = std::chrono::duration_cast<Duration>(Clock::now() - next_deadline_);
+    next_deadline_ += period_;
+    return tick;
+}
+
+template <typename Clock>
+auto BasicTickPacer<Clock>::reset() -> void {
+    next_deadline_ = Clock::now() + period_;
+    next_index_    = 0u;
+}
+
+template <typename Clock>
+auto BasicTickPacer<Clock>::period() const -> Duration {
+    return std::chrono::duration_cast<Duration>(period_);
+}
+
+template <typename Clock>
+auto BasicTickPacer<Clock>::next_deadline() const -> typename Clock::time_point {
+    return next_deadline_;
+}
+
+template <typename Clock>
+auto BasicTickPacer<Clock>::missed_ticks() const -> std::uint64_t {
+    return missed_ticks_;
+}
+
+} // namespace ltb::util
@@ -0,0 +1,293 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "clock.hpp"
+#include "cpu.hpp"
+#include "duration.hpp"
+
+// standard
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace ltb::util {
+
+/**
+ * @brief A lock-free token bucket: `rate` tokens are added every `period`, up to `burst` tokens.
+ *
+ * Implemented as a generic cell rate algorithm (GCRA). The only state is the time the bucket
+ * would next be full ("theoretical arrival time"), so acquiring tokens is a single CAS.
+ * The bucket starts full.
+ *
+ * Example:
+ *
+ *     // 100 requests per second with bursts of up to 10
+ *     auto limiter = ltb::util::TokenBucket(100u, ltb::util::duration_seconds(1), 10u);
+ *
+ *     if (limiter.try_acquire()) {
+ *         send_request();
+ *     }
+ */
+template <typename Clock>
+class BasicTokenBucket {
+public:
+    /// \throws std::invalid_argument if `rate` or `burst` is zero, or more than one token
+    ///         would be added per tick of `Clock`.
+    BasicTokenBucket(std::uint64_t rate, Duration period, std::uint64_t burst);
+
+    /// \brief Take `tokens` if they are available now. Never blocks.
+    [[nodiscard]] auto try_acquire(std::uint64_t tokens = 1u) -> bool;
+
+    /// \brief Reserve `tokens` and sleep until they are available, unless that would take
+    ///        longer than `timeout`, in which case nothing is taken and false is returned
+    ///        immediately. Requests larger than `burst` can only be served this way.
+    [[nodiscard]] auto acquire(std::uint64_t tokens, Duration timeout) -> bool;
+
+    /// \brief How long until `tokens` could be taken, if no one else takes any.
+    [[nodiscard]] auto time_until_available(std::uint64_t tokens = 1u) const -> Duration;
+
+private:
+    using Ticks = typename Clock::rep;
+
+    Ticks emission_interval_; ///< Time to add one token
+    Ticks burst_tolerance_;   ///< Time to fill the whole bucket
+
+    /// \brief When the bucket will be full again. On its own cache line since every thread writes it.
+    alignas(cache_line_size) std::atomic<Ticks> theoretical_arrival_ = {std::numeric_limits<Ticks>::min()};
+
+    /// \return When the tokens are available (possibly now), or nothing if that is after `max_wait`.
+    auto reserve(std::uint64_t tokens, Ticks max_wait) -> std::optional<Ticks>;
+};
+
+/**
+ * @brief A lock-free sliding window limiter: at most `limit` tokens in any `window`.
+ *
+ * Uses the sliding window counter approximation: counts are kept for the current and
+ * previous fixed windows, and the previous window's count is weighted by how much of it
+ * still overlaps the sliding window. Each window's count shares an atomic word with the
+ * window's index so acquiring tokens is a single CAS.
+ *
+ * Example:
+ *
+ *     // No more than 1000 log messages per minute
+ *     auto limiter = ltb::util::SlidingWindowLimiter(1000u, ltb::util::duration_minutes(1));
+ */
+template <typename Clock>
+class BasicSlidingWindowLimiter {
+public:
+    /// \throws std::invalid_argument if `limit` or `window` is zero.
+    BasicSlidingWindowLimiter(std::uint32_t limit, Duration window);
+
+    /// \brief Take `tokens` if they fit in the window now. Never blocks.
+    [[nodiscard]] auto try_acquire(std::uint32_t tokens = 1u) -> bool;
+
+    /// \brief Retry until `tokens` fit in the window, sleeping in between, or `timeout` passes.
+    [[nodiscard]] auto acquire(std::uint32_t tokens, Duration timeout) -> bool;
+
+    /// \brief Roughly how long until `tokens` fit in the window, if no one else takes any.
+    [[nodiscard]] auto time_until_available(std::uint32_t tokens = 1u) const -> Duration;
+
+private:
+    using Ticks = typename Clock::rep;
+
+    struct WindowState {
+        std::int64_t  index;            ///< Current fixed window
+        double        elapsed_fraction; ///< Of the current window
+        std::uint64_t current_count;
+        std::uint64_t previous_count;
+    };
+
+    std::uint32_t limit_;
+    Ticks         window_;
+
+    /// \brief Window `i` is counted in slot `i % 2` as `(low 32 bits of i) << 32 | count`.
+    alignas(cache_line_size) std::array<std::atomic<std::uint64_t>, 2> slots_ = {};
+
+    auto state(Ticks now) const -> WindowState;
+};
+
+using TokenBucket          = BasicTokenBucket<SteadyClock>;
+using SlidingWindowLimiter = BasicSlidingWindowLimiter<SteadyClock>;
+
+/// \brief Takes a token and returns zero, or returns how long to wait in real time before trying
+///        again. Used by `AsyncTaskRunner` to defer tasks.
+using RateLimit = std::function<Duration()>;
+
+/// \brief Adapt any limiter above to a `RateLimit`. `limiter` must outlive the result.
+///
+/// The wait is roughly how long until a token is available. For clocks that don't follow
+/// real time (`ManualClock`) it is capped at a millisecond so the limiter is polled again
+/// soon after the clock is advanced.
+template <template <typename> typename Limiter, typename Clock>
+auto rate_limit(Limiter<Clock>& limiter) -> RateLimit {
+    return [&limiter] {
+        if (limiter.try_acquire()) {
+            return Duration::zero();
+        }
+        auto const wait = std::max(limiter.time_until_available(), Duration(1));
+        if constexpr (!ClockTraits<Clock>::follows_real_time) {
+            return std::min(wait, Duration(std::chrono::milliseconds(1)));
+        } else {
+            return wait;
+        }
+    };
+}
+
+template <typename Clock>
+BasicTokenBucket<Clock>::BasicTokenBucket(std::uint64_t rate, Duration period, std::uint64_t burst) {
+    auto const period_ticks = std::chrono::duration_cast<typename Clock::duration>(period).count();
+    if (rate == 0u || burst == 0u || period_ticks < static_cast<Ticks>(rate)) {
+        throw std::invalid_argument("Token bucket rate and burst must be positive and at most one token per tick");
+    }
+    emission_interval_ = period_ticks / static_cast<Ticks>(rate);
+    burst_tolerance_   = emission_interval_ * static_cast<Ticks>(burst);
+}
+
+template <typename Clock>
+auto BasicTokenBucket<Clock>::try_acquire(std::uint64_t tokens) -> bool {
+    return reserve(tokens, Ticks{0}).has_value();
+}
+
+template <typename Clock>
+auto BasicTokenBucket<Clock>::acquire(std::uint64_t tokens, Duration timeout) -> bool {
+    auto const max_wait = std::chrono::duration_cast<typename Clock::duration>(timeout).count();
+    if (auto const available = reserve(tokens, std::max(max_wait, Ticks{0}))) {
+        auto const available_time = typename Clock::time_point(typename Clock::duration(*available));
+        if (available_time > Clock::now()) {
+            sleep_until(available_time);
+        }
+        return true;
+    }
+    return false;
+}
+
+template <typename Clock>
+auto BasicTokenBucket<Clock>::time_until_available(std::uint64_t tokens) const -> Duration {
+    auto const now       = Clock::now().time_since_epoch().count();
+    auto const start     = std::max(theoretical_arrival_.load(std::memory_order_relaxed), now);
+    auto const available = start + static_cast<Ticks>(tokens) * emission_interval_ - burst_tolerance_;
+    return std::chrono::duration_cast<Duration>(typename Clock::duration(std::max(available - now, Ticks{0})));
+}
+
+template <typename Clock>
+auto BasicTokenBucket<Clock>::reserve(std::uint64_t tokens, Ticks max_wait) -> std::optional<Ticks> {
+    auto const now     = Clock::now().time_since_epoch().count();
+    auto const cost    = static_cast<Ticks>(tokens) * emission_interval_;
+    auto       arrival = theoretical_arrival_.load(std::memory_order_relaxed);
+
+    while (true) {
+        auto const new_arrival = std::max(arrival, now) + cost;
+        auto const available   = new_arrival - burst_tolerance_;
+        if (available - now > max_wait) {
+            return std::nullopt;
+        }
+        if (theoretical_arrival_.compare_exchange_weak(arrival, new_arrival, std::memory_order_relaxed)) {
+            return std::max(available, now);
+        }
+    }
+}
+
+template <typename Clock>
+BasicSlidingWindowLimiter<Clock>::BasicSlidingWindowLimiter(std::uint32_t limit, Duration window)
+    : limit_(limit), window_(std::chrono::duration_cast<typename Clock::duration>(window).count()) {
+    if (limit_ == 0u || window_ <= Ticks{0}) {
+        throw std::invalid_argument("Sliding window limit and window must be positive");
+    }
+    // Start with both slots holding windows that can't be current or previous.
+    auto const index = Clock::now().time_since_epoch().count() / window_;
+    auto const stale = (static_cast<std::uint64_t>(index) - 2u) << 32u;
+    slots_[0].store(stale, std::memory_order_relaxed);
+    slots_[1].store(stale, std::memory_order_relaxed);
+}
+
+template <typename Clock>
+auto BasicSlidingWindowLimiter<Clock>::try_acquire(std::uint32_t tokens) -> bool {
+    auto const now   = Clock::now().time_since_epoch().count();
+    auto const index = now / window_;
+    auto const tag   = static_cast<std::uint64_t>(index) << 32u;
+    auto&      slot  = slots_[static_cast<std::size_t>(index) & 1u];
+
+    // Rounded down so the estimate is never more than one token too lenient.
+    auto const current  = state(now);
+    auto const weighted = static_cast<std::uint64_t>(static_cast<double>(current.previous_count)
+                                                     * (1.0 - current.elapsed_fraction));
+
+    auto word = slot.load(std::memory_order_relaxed);
+    while (true) {
+        // The slot holds a count from two windows ago until the first acquire in this window.
+        auto const count = (word & ~std::uint64_t{0xffffffffu}) == tag ? (word & 0xffffffffu) : 0u;
+        if (weighted + count + tokens > limit_) {
+            return false;
+        }
+        if (slot.compare_exchange_weak(word, tag | (count + tokens), std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+template <typename Clock>
+auto BasicSlidingWindowLimiter<Clock>::acquire(std::uint32_t tokens, Duration timeout) -> bool {
+    auto const deadline = Clock::now() + std::chrono::duration_cast<typename Clock::duration>(timeout);
+    while (!try_acquire(tokens)) {
+        auto const now  = Clock::now();
+        auto const wait = std::chrono::duration_cast<typename Clock::duration>(time_until_available(tokens));
+        if (wait > deadline - now) {
+            return false;
+        }
+        sleep_until(now + std::max(wait, typename Clock::duration(1)));
+    }
+    return true;
+}
+
+template <typename Clock>
+auto BasicSlidingWindowLimiter<Clock>::time_until_available(std::uint32_t tokens) const -> Duration {
+    if (tokens > limit_) {
+        return Duration::max();
+    }
+    auto const current = state(Clock::now().time_since_epoch().count());
+    auto const limit   = static_cast<double>(limit_);
+    auto const window  = static_cast<double>(window_);
+
+    // Fraction of a window to wait for the weighted count to drop by enough.
+    auto wait = 0.0;
+    if (current.current_count + tokens <= limit_) {
+        if (current.previous_count > 0u) {
+            auto const allowed_overlap = (limit - static_cast<double>(current.current_count + tokens))
+                                       / static_cast<double>(current.previous_count);
+            wait = std::max(0.0, (1.0 - allowed_overlap) - current.elapsed_fraction);
+        }
+    } else {
+        // Wait for the next window, where the current count becomes the weighted previous count.
+        auto const allowed_overlap = (limit - tokens) / static_cast<double>(current.current_count);
+        wait = (1.0 - current.elapsed_fraction) + std::max(0.0, 1.0 - allowed_overlap);
+    }
+    return std::chrono::duration_cast<Duration>(typename Clock::duration(static_cast<Ticks>(wait * window)));
+}
+
+template <typename Clock>
+auto BasicSlidingWindowLimiter<Clock>::state(Ticks now) const -> WindowState {
+    auto const index = now / window_;
+
+    auto count_in = [this](std::int64_t window_index) -> std::uint64_t {
+        auto const word = slots_[static_cast<std::size_t>(window_index) & 1u].load(std::memory_order_relaxed);
+        return (word >> 32u) == (static_cast<std::uint64_t>(window_index) & 0xffffffffu) ? (word & 0xffffffffu) : 0u;
+    };
+
+    return {
+        index,
+        static_cast<double>(now % window_) / static_cast<double>(window_),
+        count_in(index),
+        count_in(index - 1),
+    };
+}
+
+} // namespace ltb::util
@@ -0,0 +1,123 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "cpu.hpp"
+#include "power_of_2.hpp"
+
+// standard
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace ltb::util {
+
+/**
+ * @brief A bounded queue that any number of threads can push to and one thread can pop from
+ *        without locking. Pushing never blocks; it fails instead when the buffer is full.
+ *
+ * Each cell has a sequence number that tells producers when it is free and the consumer
+ * when it holds a value, so producers only contend on claiming a position (one CAS).
+ *
+ * Example:
+ *
+ *     auto events = ltb::util::MpscRingBuffer<Event>(1024u);
+ *
+ *     // Any thread
+ *     if (!events.try_push(event)) {
+ *         ++dropped_events;
+ *     }
+ *
+ *     // Consumer thread
+ *     while (auto event = events.try_pop()) {
+ *         handle(*event);
+ *     }
+ */
+template <typename T>
+class MpscRingBuffer {
+public:
+    /// \param min_capacity - rounded up to the next power of 2.
+    explicit MpscRingBuffer(std::size_t min_capacity);
+
+    /// \return false if the buffer is full. Safe to call from any thread.
+    template <typename U>
+    auto try_push(U&& value) -> bool;
+
+    /// \return The oldest value or nothing if the buffer is empty. Only one thread may pop.
+    auto try_pop() -> std::optional<T>;
+
+    [[nodiscard]] auto capacity() const -> std::size_t;
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence = {0u};
+        T                        value    = {};
+    };
+
+    std::size_t             mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(cache_line_size) std::atomic<std::size_t> tail_ = {0u}; ///< Claimed by producers
+    alignas(cache_line_size) std::size_t head_              = 0u;   ///< Only touched by the consumer
+};
+
+template <typename T>
+MpscRingBuffer<T>::MpscRingBuffer(std::size_t min_capacity)
+    : mask_(static_cast<std::size_t>(next_power_of_2(std::max(min_capacity, std::size_t{1u}))) - 1u),
+      cells_(std::make_unique<Cell[]>(mask_ + 1u)) {
+    for (auto i = std::size_t{0u}; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+template <typename U>
+auto MpscRingBuffer<T>::try_push(U&& value) -> bool {
+    auto position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        auto&      cell     = cells_[position & mask_];
+        auto const sequence = cell.sequence.load(std::memory_order_acquire);
+        auto const diff     = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+        if (diff == 0) {
+            // The cell is free. Claim it (this updates `position` if another producer got there first).
+            if (tail_.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed)) {
+                cell.value = std::forward<U>(value);
+                cell.sequence.store(position + 1u, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // The consumer hasn't popped the value written a lap ago.
+            return false;
+        } else {
+            position = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+auto MpscRingBuffer<T>::try_pop() -> std::optional<T> {
+    auto&      cell     = cells_[head_ & mask_];
+    auto const sequence = cell.sequence.load(std::memory_order_acquire);
+
+    if (sequence != head_ + 1u) {
+        return std::nullopt;
+    }
+    auto value = std::optional<T>(std::move(cell.value));
+    cell.sequence.store(head_ + mask_ + 1u, std::memory_order_release);
+    ++head_;
+    return value;
+}
+
+template <typename T>
+auto MpscRingBuffer<T>::capacity() const -> std::size_t {
+    return mask_ + 1u;
+}
+
+} // namespace ltb::util
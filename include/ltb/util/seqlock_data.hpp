@@ -0,0 +1,181 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "atomic_data.hpp"
+#include "cpu.hpp"
+
+// standard
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ltb::util {
+
+/**
+ * @brief Owns small, trivially copyable data that can be read without taking a lock.
+ *
+ * Writers are serialized by bumping a sequence counter to an odd value while they
+ * write and back to an even value when they finish. Readers never block a writer;
+ * they copy the data and retry only if the sequence changed while they were copying.
+ *
+ * Example:
+ *
+ *     struct Pose {
+ *         float position[3];
+ *         float orientation[4];
+ *     };
+ *
+ *     ltb::util::SeqLockData<Pose> shared_pose;
+ *
+ *     ... Later, in different threads
+ *
+ *     shared_pose.store(new_pose);     // writer
+ *     Pose pose = shared_pose.load();  // readers
+ *
+ *     shared_pose.use_safely([] (Pose& pose) {
+ *         // Read-modify-write 'pose' here. Other writers wait, readers retry.
+ *     });
+ */
+template <typename T>
+class alignas(cache_line_size) SeqLockData {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLockData requires trivially copyable data");
+    static_assert(std::is_default_constructible_v<T>, "SeqLockData requires default constructible data");
+
+    explicit SeqLockData(T const& data = T{});
+
+    /// \brief Modify the data. Concurrent writers wait for each other but readers are never blocked.
+    template <typename Func>
+    auto use_safely(Func func);
+
+    /// \brief Get a consistent copy of the data without locking (name is taken from std::atomic::load).
+    auto load() const -> T;
+
+    /// \brief Set the data (name is taken from std::atomic::store).
+    auto store(T const& data) -> void;
+
+private:
+    using Word = std::size_t;
+
+    static constexpr auto word_count = (sizeof(T) + sizeof(Word) - 1u) / sizeof(Word);
+
+    std::atomic<std::uint64_t>                sequence_ = {0u};
+    std::array<std::atomic<Word>, word_count> words_;
+
+    /// \brief Spin until no other writer is active then mark the data as being written.
+    auto begin_write() -> std::uint64_t;
+    auto end_write(std::uint64_t odd_sequence) -> void;
+
+    auto read_words() const -> T;
+    auto write_words(T const& data) -> void;
+};
+
+/// \brief True if `T` is small and simple enough that `SeqLockData` is cheaper than `AtomicData`.
+template <typename T>
+constexpr auto prefer_seqlock_v = std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>
+                               && sizeof(T) <= cache_line_size - sizeof(std::uint64_t);
+
+/// \brief Selects `SeqLockData<T>` when `T` qualifies and falls back to `AtomicData<T>` otherwise.
+///        Only `load`, `store`, and non-const `use_safely` should be used through this alias.
+template <typename T>
+using AtomicValue = std::conditional_t<prefer_seqlock_v<T>, SeqLockData<T>, AtomicData<T>>;
+
+template <typename T>
+SeqLockData<T>::SeqLockData(T const& data) {
+    write_words(data);
+}
+
+template <typename T>
+template <typename Func>
+auto SeqLockData<T>::use_safely(Func func) {
+    // Readers only retry if the sequence is left odd, so finish the write even if `func` throws.
+    struct WriteGuard {
+        SeqLockData*  self;
+        std::uint64_t odd_sequence;
+        ~WriteGuard() { self->end_write(odd_sequence); }
+    };
+    auto guard = WriteGuard{this, begin_write()};
+
+    auto data = read_words();
+    if constexpr (std::is_void_v<decltype(func(data))>) {
+        func(data);
+        write_words(data);
+    } else {
+        auto result = func(data);
+        write_words(data);
+        return result;
+    }
+}
+
+template <typename T>
+auto SeqLockData<T>::load() const -> T {
+    while (true) {
+        auto const before = sequence_.load(std::memory_order_acquire);
+        if ((before & 1u) != 0u) {
+            cpu_relax(); // A writer is active.
+            continue;
+        }
+
+        auto data = read_words();
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence_.load(std::memory_order_relaxed) == before) {
+            return data;
+        }
+    }
+}
+
+template <typename T>
+auto SeqLockData<T>::store(T const& data) -> void {
+    auto const odd_sequence = begin_write();
+    write_words(data);
+    end_write(odd_sequence);
+}
+
+template <typename T>
+auto SeqLockData<T>::begin_write() -> std::uint64_t {
+    auto sequence = sequence_.load(std::memory_order_relaxed);
+    while ((sequence & 1u) != 0u
+           || !sequence_.compare_exchange_weak(sequence,
+                                               sequence + 1u,
+                                               std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+        cpu_relax();
+        sequence = sequence_.load(std::memory_order_relaxed);
+    }
+    // Keep the data writes from being reordered before the odd sequence number.
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence + 1u;
+}
+
+template <typename T>
+auto SeqLockData<T>::end_write(std::uint64_t odd_sequence) -> void {
+    sequence_.store(odd_sequence + 1u, std::memory_order_release);
+}
+
+template <typename T>
+auto SeqLockData<T>::read_words() const -> T {
+    auto buffer = std::array<Word, word_count>{};
+    for (auto i = 0u; i < word_count; ++i) {
+        buffer[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    auto data = T{};
+    std::memcpy(static_cast<void*>(&data), buffer.data(), sizeof(T));
+    return data;
+}
+
+template <typename T>
+auto SeqLockData<T>::write_words(T const& data) -> void {
+    auto buffer = std::array<Word, word_count>{};
+    std::memcpy(buffer.data(), &data, sizeof(T));
+    for (auto i = 0u; i < word_count; ++i) {
+        words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+}
+
+} // namespace ltb::util
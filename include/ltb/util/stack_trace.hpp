@@ -0,0 +1,61 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace ltb::util {
+
+/**
+ * @brief The raw return addresses of a call stack, captured without allocating.
+ *
+ * When the library is built with the `LTB_ERROR_STACK_TRACES` CMake option, which turns on
+ * frame pointers for everything linking the library, the stack is walked through the frame
+ * pointers on Linux x86_64 and aarch64. That takes tens of nanoseconds. Otherwise `backtrace`
+ * is used, which doesn't need frame pointers but takes microseconds.
+ *
+ * Addresses are only turned into names when the trace is printed:
+ *
+ *     auto const trace = ltb::util::StackTrace::capture();
+ *     ...
+ *     std::cerr << trace.to_string();
+ */
+class StackTrace {
+public:
+    static constexpr auto max_frames = std::size_t{32};
+
+    /// \brief The calling thread's stack, starting at the caller of `capture` and
+    ///        skipping another `skip` frames from there.
+    static auto capture(std::size_t skip = 0u) -> StackTrace;
+
+    [[nodiscard]] auto size() const -> std::size_t;
+    [[nodiscard]] auto empty() const -> bool;
+    [[nodiscard]] auto begin() const -> void* const*;
+    [[nodiscard]] auto end() const -> void* const*;
+
+    /// \brief One line per frame: "#index address symbol+offset (module)".
+    [[nodiscard]] auto to_string() const -> std::string;
+
+private:
+    std::array<void*, max_frames> frames_ = {};
+    std::size_t                   size_   = 0u;
+};
+
+/// \brief A readable name for a return address. Each address is only looked up once.
+///
+/// Function names are only found for symbols the dynamic linker can see (link with
+/// `-rdynamic` to include the executable's own functions). Otherwise the module and
+/// offset are given, which `addr2line` can resolve.
+auto symbolize(void* address) -> std::string;
+
+/// \brief Whether new `Error`s capture a stack trace. On by default when the library is
+///        built with `LTB_ERROR_STACK_TRACES` defined, otherwise off.
+/// \return The previous setting.
+auto set_error_stack_traces_enabled(bool enabled) -> bool;
+auto error_stack_traces_enabled() -> bool;
+
+} // namespace ltb::util
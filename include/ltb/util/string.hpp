@@ -11,4 +11,7 @@ auto starts_with(std::string const& str, std::string const& prefix) -> bool;
 
 auto to_lower_ascii(std::string const& str) -> std::string;
 
+/// \brief Quote `str` and escape any characters that aren't allowed in a JSON string.
+auto to_json_string(std::string const& str) -> std::string;
+
 } // namespace ltb::util
@@ -0,0 +1,41 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+
+// standard
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace ltb::util {
+
+/// \brief The CPU time used by the calling thread as a `std::chrono` clock. It doesn't advance
+///        while the thread is blocked, so comparing it against wall time shows how long a
+///        region spent waiting on locks or I/O. Time points are only comparable on one thread.
+class ThreadCpuClock {
+public:
+    using duration   = Duration;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<ThreadCpuClock>;
+
+    static constexpr bool is_steady = true;
+
+    static auto now() noexcept -> time_point;
+};
+
+/// \brief The number of times a thread has given up the CPU.
+struct ContextSwitches {
+    std::int64_t voluntary   = 0; ///< Blocked on a lock, condition variable, I/O, or sleep
+    std::int64_t involuntary = 0; ///< Preempted by the scheduler
+};
+
+/// \return Context switches of the calling thread so far, or nothing on platforms that
+///         don't count them per thread (only Linux's `RUSAGE_THREAD` is supported).
+auto thread_context_switches() -> std::optional<ContextSwitches>;
+
+} // namespace ltb::util
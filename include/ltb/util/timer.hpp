@@ -22,32 +22,167 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// project
+#include "latency_histogram.hpp"
+#include "thread_clock.hpp"
+#include "timer_sink.hpp"
+
 // standard
 #include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <optional>
 #include <string>
 
 namespace ltb::util {
 
-class Timer {
+/// \brief Measures the time since `start` was called using `Clock`.
+///        Use `TscClock` for very short regions where the cost of `steady_clock::now()` matters.
+template <typename Clock>
+class BasicTimer {
 public:
-    explicit Timer(std::string name = "", std::ostream* os = nullptr);
+    explicit BasicTimer(std::string name = "", std::ostream* os = nullptr);
     auto start() -> void;
     auto millis_since_start() -> double;
 
+    /// \brief The time since `start` was called (or since construction). Never prints.
+    [[nodiscard]] auto elapsed() const -> typename Clock::duration;
+
+    /// \brief When `start` was called (or when the timer was constructed).
+    [[nodiscard]] auto start_time() const -> typename Clock::time_point;
+
+private:
+    std::string                name_;
+    std::ostream*              ostream_;
+    typename Clock::time_point start_time_;
+};
+
+/// \brief Prints the time between its construction and destruction, records it in a
+///        histogram, or submits it to a sink that writes it on another thread.
+template <typename Clock>
+class BasicScopedTimer {
+public:
+    explicit BasicScopedTimer(std::string name, std::ostream& os = std::cout);
+    explicit BasicScopedTimer(LatencyHistogram& histogram);
+
+    /// \brief Only captures the start time and `name_id` (from `timer_name_id`) so the
+    ///        timed thread never formats or writes anything.
+    BasicScopedTimer(TimerSink& sink, std::uint32_t name_id);
+
+    ~BasicScopedTimer();
+
+private:
+    BasicTimer<Clock> timer_;
+    LatencyHistogram* histogram_ = nullptr;
+    TimerSink*        sink_      = nullptr;
+    std::uint32_t     name_id_   = 0u;
+};
+
+using Timer       = BasicTimer<std::chrono::steady_clock>;
+using ScopedTimer = BasicScopedTimer<std::chrono::steady_clock>;
+
+/// \brief Wall time and CPU time of the timed thread, plus its context switches if they were counted.
+struct ThreadTimes {
+    Duration                       wall     = {};
+    Duration                       cpu      = {};
+    std::optional<ContextSwitches> switches = {};
+
+    /// \brief Wall time the thread wasn't running (waiting on locks or I/O, sleeping, or preempted).
+    [[nodiscard]] auto off_cpu() const -> Duration;
+};
+
+auto operator<<(std::ostream& os, ThreadTimes const& times) -> std::ostream&;
+
+/// \brief Measures both wall time and the calling thread's CPU time since `start` was called.
+///        Must be started and read on the same thread.
+class ThreadTimer {
+public:
+    /// \param count_context_switches - also count voluntary and involuntary context switches
+    ///        (adds a system call to `start` and `elapsed`).
+    explicit ThreadTimer(bool count_context_switches = false);
+
+    auto start() -> void;
+
+    [[nodiscard]] auto elapsed() const -> ThreadTimes;
+
 private:
-    std::string                                        name_;
-    std::ostream*                                      ostream_;
-    std::chrono::time_point<std::chrono::steady_clock> start_time_;
+    bool                                  count_context_switches_;
+    std::optional<ContextSwitches>        start_switches_;
+    ThreadCpuClock::time_point            start_cpu_;
+    std::chrono::steady_clock::time_point start_wall_;
 };
 
-class ScopedTimer {
+/// \brief Prints the wall time and thread CPU time between its construction and destruction.
+class ScopedThreadTimer {
 public:
-    explicit ScopedTimer(std::string name, std::ostream& os = std::cout);
-    ~ScopedTimer();
+    explicit ScopedThreadTimer(std::string   name,
+                               std::ostream& os                     = std::cout,
+                               bool          count_context_switches = false);
+    ~ScopedThreadTimer();
 
 private:
-    Timer timer_;
+    std::string   name_;
+    std::ostream& ostream_;
+    ThreadTimer   timer_;
 };
 
+template <typename Clock>
+BasicTimer<Clock>::BasicTimer(std::string name, std::ostream* os)
+    : name_(std::move(name)), ostream_(os), start_time_(Clock::now()) {}
+
+template <typename Clock>
+auto BasicTimer<Clock>::start() -> void {
+    if (ostream_) {
+        (*ostream_) << name_ << "..." << std::endl;
+    }
+    start_time_ = Clock::now();
+}
+
+template <typename Clock>
+auto BasicTimer<Clock>::millis_since_start() -> double {
+    auto end_time = Clock::now();
+    auto duration = std::chrono::duration<double, std::milli>(end_time - start_time_).count();
+
+    if (ostream_) {
+        (*ostream_) << name_ << (name_.empty() ? "" : ": ") << std::to_string(duration) << "ms" << std::endl;
+    }
+
+    return duration;
+}
+
+template <typename Clock>
+auto BasicTimer<Clock>::elapsed() const -> typename Clock::duration {
+    return Clock::now() - start_time_;
+}
+
+template <typename Clock>
+auto BasicTimer<Clock>::start_time() const -> typename Clock::time_point {
+    return start_time_;
+}
+
+template <typename Clock>
+BasicScopedTimer<Clock>::BasicScopedTimer(std::string name, std::ostream& os) : timer_(std::move(name), &os) {
+    timer_.start();
+}
+
+template <typename Clock>
+BasicScopedTimer<Clock>::BasicScopedTimer(LatencyHistogram& histogram) : histogram_(&histogram) {}
+
+template <typename Clock>
+BasicScopedTimer<Clock>::BasicScopedTimer(TimerSink& sink, std::uint32_t name_id) : sink_(&sink), name_id_(name_id) {}
+
+template <typename Clock>
+BasicScopedTimer<Clock>::~BasicScopedTimer() {
+    if (histogram_) {
+        histogram_->record(std::chrono::duration_cast<Duration>(timer_.elapsed()));
+    } else if (sink_) {
+        auto const elapsed     = std::chrono::duration_cast<Duration>(timer_.elapsed());
+        auto const start_nanos = to_nanos<std::int64_t>(
+            std::chrono::duration_cast<Duration>(timer_.start_time().time_since_epoch()));
+        sink_->submit({name_id_, start_nanos, elapsed});
+    } else {
+        timer_.millis_since_start();
+    }
+}
+
 } // namespace ltb::util
@@ -0,0 +1,98 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "duration.hpp"
+#include "ring_buffer.hpp"
+
+// standard
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ltb::util {
+
+/// \brief The raw measurement taken by a timer. Formatting is left to the sink.
+struct TimerReport {
+    std::uint32_t name_id     = 0u; ///< From `timer_name_id`
+    std::int64_t  start_nanos = 0;  ///< Since the timer clock's epoch
+    Duration      elapsed     = {};
+};
+
+/// \brief Get a small id for `name` that can be passed to timers instead of a string.
+///        Takes a lock so the id should be looked up once and reused.
+auto timer_name_id(std::string const& name) -> std::uint32_t;
+
+/// \brief The name registered for `id`, or an empty string if `id` is unknown.
+auto timer_name(std::uint32_t id) -> std::string;
+
+/// \brief Receives reports from timers when they finish.
+class TimerSink {
+public:
+    virtual ~TimerSink() = default;
+
+    /// \brief Called on the timed thread so it should be cheap and never block.
+    virtual auto submit(TimerReport const& report) -> void = 0;
+};
+
+/**
+ * @brief Queues reports in a lock-free ring buffer and writes them from a background thread.
+ *
+ * The timed thread only pushes a `TimerReport`. Names are looked up, formatted, and written
+ * to the stream in batches without flushing. Reports are dropped (and counted) if the buffer
+ * fills up faster than the background thread can empty it.
+ *
+ * Example:
+ *
+ *     auto sink = ltb::util::AsyncTimerSink(std::cout);
+ *
+ *     static auto const update_id = ltb::util::timer_name_id("update");
+ *     {
+ *         auto timer = ltb::util::ScopedTimer(sink, update_id);
+ *         update();
+ *     } // Writes "update: 1.234567ms" later on the sink's thread
+ */
+class AsyncTimerSink : public TimerSink {
+public:
+    /// \param capacity - the number of reports that can be queued before they are dropped.
+    /// \param write_interval - how often the background thread writes queued reports.
+    explicit AsyncTimerSink(std::ostream& os,
+                            std::size_t   capacity       = 4096u,
+                            Duration      write_interval = duration_millis(10));
+
+    /// \brief Writes any remaining reports and flushes the stream.
+    ~AsyncTimerSink() override;
+
+    auto submit(TimerReport const& report) -> void override;
+
+    /// \brief Block until every report submitted before this call has been written, then flush the stream.
+    auto flush() -> void;
+
+    /// \brief The number of reports dropped because the buffer was full.
+    [[nodiscard]] auto dropped() const -> std::uint64_t;
+
+private:
+    std::ostream&               os_;
+    Duration                    write_interval_;
+    MpscRingBuffer<TimerReport> reports_;
+    std::atomic<std::uint64_t>  dropped_ = {0u};
+
+    std::mutex              mutex_;
+    std::condition_variable wake_writer_;
+    std::condition_variable flushed_;
+    std::uint64_t           flushes_requested_ = 0u; ///< Guarded by `mutex_`
+    std::uint64_t           flushes_completed_ = 0u; ///< Guarded by `mutex_`
+    bool                    stopping_          = false; ///< Guarded by `mutex_`
+
+    std::thread writer_thread_;
+
+    auto write_loop() -> void;
+};
+
+} // namespace ltb::util
@@ -0,0 +1,114 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "cpu.hpp"
+
+// standard
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace ltb::util {
+
+/**
+ * @brief Hands the latest value from one producer thread to one consumer thread
+ *        without either side ever waiting for the other.
+ *
+ * The writer fills a back buffer and atomically swaps it with a shared middle
+ * buffer. The reader swaps the middle buffer with its front buffer only when a
+ * newer value has been published, so it always sees the newest complete value
+ * and never copies it. Values that are overwritten before being read are skipped.
+ *
+ * Example:
+ *
+ *     ltb::util::TripleBuffer<Frame> frames;
+ *
+ *     // Producer thread
+ *     Frame& frame = frames.write_buffer();
+ *     render_into(frame);
+ *     frames.publish();
+ *
+ *     // Consumer thread
+ *     Frame const& latest = frames.read();
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    explicit TripleBuffer(T const& initial_value = T{});
+
+    /// \brief The buffer the writer can fill. It is never seen by the reader until `publish` is called.
+    ///        Its contents are whatever was written to it two publishes ago (or the initial value).
+    auto write_buffer() -> T&;
+
+    /// \brief Make the write buffer available to the reader and get a new write buffer.
+    auto publish() -> void;
+
+    /// \brief Copy or move `value` into the write buffer then publish it.
+    template <typename U>
+    auto write(U&& value) -> void;
+
+    /// \return true if a value has been published since the last call to `read`.
+    [[nodiscard]] auto has_update() const -> bool;
+
+    /// \brief Get the newest published value. The reference stays valid until the next call to `read`.
+    auto read() -> T const&;
+
+private:
+    // The middle index is shared between threads. The flag marks a value that hasn't been read yet.
+    static constexpr auto index_mask = std::uint8_t{0b011u};
+    static constexpr auto fresh_bit  = std::uint8_t{0b100u};
+
+    struct alignas(cache_line_size) Slot {
+        T value;
+    };
+
+    std::array<Slot, 3> slots_;
+
+    alignas(cache_line_size) std::atomic<std::uint8_t> middle_ = {1u};
+    alignas(cache_line_size) std::uint8_t write_index_         = 0u; ///< Only touched by the writer
+    alignas(cache_line_size) std::uint8_t read_index_          = 2u; ///< Only touched by the reader
+};
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer(T const& initial_value)
+    : slots_{Slot{initial_value}, Slot{initial_value}, Slot{initial_value}} {}
+
+template <typename T>
+auto TripleBuffer<T>::write_buffer() -> T& {
+    return slots_[write_index_].value;
+}
+
+template <typename T>
+auto TripleBuffer<T>::publish() -> void {
+    // Release the written data to the reader and acquire the buffer it gave back.
+    auto const previous_middle
+        = middle_.exchange(static_cast<std::uint8_t>(write_index_ | fresh_bit), std::memory_order_acq_rel);
+    write_index_ = static_cast<std::uint8_t>(previous_middle & index_mask);
+}
+
+template <typename T>
+template <typename U>
+auto TripleBuffer<T>::write(U&& value) -> void {
+    write_buffer() = std::forward<U>(value);
+    publish();
+}
+
+template <typename T>
+auto TripleBuffer<T>::has_update() const -> bool {
+    return (middle_.load(std::memory_order_relaxed) & fresh_bit) != 0u;
+}
+
+template <typename T>
+auto TripleBuffer<T>::read() -> T const& {
+    if (has_update()) {
+        auto const previous_middle = middle_.exchange(read_index_, std::memory_order_acq_rel);
+        read_index_                = static_cast<std::uint8_t>(previous_middle & index_mask);
+    }
+    return slots_[read_index_].value;
+}
+
+} // namespace ltb::util
@@ -0,0 +1,119 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "cpu.hpp"
+#include "duration.hpp"
+
+// standard
+#include <chrono>
+#include <cstdint>
+
+namespace ltb::util {
+namespace detail {
+
+struct TscCalibration {
+    bool          use_tsc          = false; ///< False if the CPU has no invariant TSC
+    std::uint64_t base_ticks       = 0u;
+    std::int64_t  base_nanos       = 0; ///< steady_clock time (in nanoseconds) at `base_ticks`
+    double        nanos_per_tick   = 0.0;
+    double        ticks_per_second = 0.0;
+};
+
+/// \brief Measure the TSC frequency against steady_clock. Blocks for a few milliseconds.
+auto calibrate_tsc() -> TscCalibration;
+
+/// \brief The calibration shared by every TscClock. Calibrated on first use.
+inline auto tsc_calibration() -> TscCalibration const& {
+    static auto const calibration = calibrate_tsc();
+    return calibration;
+}
+
+inline auto steady_nanos() -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace detail
+
+/**
+ * @brief A steady clock that reads the CPU's time stamp counter.
+ *
+ * Reading the TSC takes a handful of cycles, compared to ~20ns for a vDSO call
+ * to `steady_clock::now()`, so it is suited to timing very short regions in hot
+ * loops. The tick rate is calibrated against `steady_clock` the first time the
+ * clock is used, which blocks for about 10ms, so call `TscClock::calibrate()` at
+ * startup to keep that out of the first timed region. Time points share
+ * `steady_clock`'s epoch.
+ *
+ * On CPUs without an invariant TSC, or on non-x86 platforms, `now()` falls back
+ * to `steady_clock::now()`.
+ *
+ * The clock meets the standard Clock requirements and its duration is `Duration`
+ * so the usual conversions work on differences between time points:
+ *
+ *     auto const start = ltb::util::TscClock::now();
+ *     ...
+ *     auto const elapsed_ns = ltb::util::to_nanos<double>(ltb::util::TscClock::now() - start);
+ */
+class TscClock {
+public:
+    using duration   = Duration;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<TscClock>;
+
+    static constexpr bool is_steady = true;
+
+    static auto now() noexcept -> time_point;
+
+    /// \brief Calibrate now instead of on the first call to `now()`. Does nothing if already calibrated.
+    static auto calibrate() -> void;
+
+    /// \return true if `now()` reads the TSC instead of falling back to steady_clock.
+    static auto uses_tsc() -> bool;
+
+    /// \return The calibrated TSC frequency, or zero if the TSC isn't used.
+    static auto ticks_per_second() -> double;
+
+    /// \brief Read the raw TSC. Waits for previous instructions to finish executing
+    ///        (`rdtscp`) so the work being timed isn't reordered after the read.
+    static auto read_ticks() noexcept -> std::uint64_t;
+};
+
+inline auto TscClock::now() noexcept -> time_point {
+    auto const& calibration = detail::tsc_calibration();
+
+    auto nanos = std::int64_t{};
+    if (calibration.use_tsc) {
+        // Signed so a core whose counter is a few ticks behind the calibrating core can't wrap around.
+        auto const elapsed_ticks = static_cast<std::int64_t>(read_ticks() - calibration.base_ticks);
+        auto const elapsed_nanos = static_cast<double>(elapsed_ticks) * calibration.nanos_per_tick;
+        nanos                    = calibration.base_nanos + static_cast<std::int64_t>(elapsed_nanos);
+    } else {
+        nanos = detail::steady_nanos();
+    }
+    return time_point(std::chrono::duration_cast<duration>(std::chrono::nanoseconds(nanos)));
+}
+
+inline auto TscClock::uses_tsc() -> bool {
+    return detail::tsc_calibration().use_tsc;
+}
+
+inline auto TscClock::ticks_per_second() -> double {
+    return detail::tsc_calibration().ticks_per_second;
+}
+
+inline auto TscClock::read_ticks() noexcept -> std::uint64_t {
+#if defined(LTB_X86)
+    auto processor_id = 0u;
+    return __rdtscp(&processor_id);
+#else
+    return 0u;
+#endif
+}
+
+} // namespace ltb::util
@@ -0,0 +1,105 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "result.hpp"
+#include "tsc_clock.hpp"
+
+// standard
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+
+namespace ltb::util {
+
+/// \brief A completed zone. Times are TscClock nanoseconds since its epoch.
+struct ZoneEvent {
+    char const*   name        = nullptr;
+    std::int64_t  begin_nanos = 0;
+    std::int64_t  end_nanos   = 0;
+    std::uint32_t depth       = 0u; ///< The number of zones this one is nested in on its thread
+};
+
+/// \brief The number of zones each thread keeps. Once a thread has recorded more than
+///        this, its oldest zones are overwritten (see `overwritten_zones`).
+constexpr auto zone_buffer_capacity = std::size_t{1u} << 15u;
+
+/// \brief The number of zones kept from threads that have exited, across all of them. Once
+///        exceeded, the oldest are dropped (see `overwritten_zones`).
+constexpr auto exited_thread_zone_capacity = zone_buffer_capacity;
+
+/// \brief Zones are only recorded while profiling is enabled. It is disabled by default.
+auto set_zone_profiling_enabled(bool enabled) -> void;
+auto zone_profiling_enabled() -> bool;
+
+/// \brief Name the calling thread in exported traces. Threads are numbered in the order they record.
+auto set_zone_thread_name(std::string name) -> void;
+
+/**
+ * @brief Records the time between its construction and destruction as a zone on the calling thread.
+ *
+ * Each thread writes zones to its own fixed-size ring buffer (allocated with its first
+ * zone) without locking or waiting on other threads. When a thread exits, its zones are
+ * copied out (up to `exited_thread_zone_capacity` across all exited threads) and the buffer
+ * is reused by the next thread to record. Nothing is printed while
+ * profiling; call `write_chrome_trace` once the interesting work is done and open
+ * the file in `chrome://tracing` or https://ui.perfetto.dev to see the zones nested
+ * on a timeline per thread.
+ *
+ * Prefer the `LTB_PROFILE_ZONE` macro, which only accepts string literals:
+ *
+ *     auto update_frame() -> void {
+ *         LTB_PROFILE_ZONE("update_frame");
+ *         {
+ *             LTB_PROFILE_ZONE("physics");
+ *             ...
+ *         }
+ *         render();
+ *     }
+ *
+ * @warning `name` must outlive the profiler (a string literal, for example) since
+ *          only the pointer is stored.
+ */
+class ScopedZone {
+public:
+    explicit ScopedZone(char const* name);
+    ~ScopedZone();
+
+    ScopedZone(ScopedZone const&) = delete;
+    ScopedZone(ScopedZone&&)      = delete;
+    auto operator=(ScopedZone const&) -> ScopedZone& = delete;
+    auto operator=(ScopedZone&&) -> ScopedZone& = delete;
+
+private:
+    char const*          name_;
+    TscClock::time_point begin_;
+    bool                 recording_;
+};
+
+/// \brief Write the zones recorded since the last `clear_zones`, up to `zone_buffer_capacity`
+///        per thread, in the Chrome trace event format. The stream's formatting is left unchanged.
+auto write_chrome_trace(std::ostream& os) -> void;
+
+/// \brief Write every zone recorded since the last `clear_zones` to a Chrome trace JSON file.
+auto write_chrome_trace(std::filesystem::path const& filename) -> Result<void>;
+
+/// \brief The number of zones recorded since the last `clear_zones` that were lost because
+///        their thread recorded more than `zone_buffer_capacity` newer zones, or because
+///        exited threads left more than `exited_thread_zone_capacity` zones behind.
+auto overwritten_zones() -> std::uint64_t;
+
+/// \brief Exclude all zones recorded so far from future exports. Safe to call while
+///        other threads are recording.
+auto clear_zones() -> void;
+
+} // namespace ltb::util
+
+#define LTB_ZONE_CONCAT_IMPL(a, b) a##b
+#define LTB_ZONE_CONCAT(a, b) LTB_ZONE_CONCAT_IMPL(a, b)
+
+///\brief Profile the rest of the enclosing scope as a zone named `name` (which must be a string literal).
+#define LTB_PROFILE_ZONE(name) ::ltb::util::ScopedZone LTB_ZONE_CONCAT(ltb_profile_zone_, __LINE__)("" name "")
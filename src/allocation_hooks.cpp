@@ -0,0 +1,160 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+
+// Replacements for the global allocation functions that count allocations per thread.
+// This file is built into the separate `LtbUtil::AllocationHooks` OBJECT library so
+// programs only pay for the counting when they opt in.
+
+#include "ltb/util/allocation_tracker.hpp"
+
+// standard
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+auto const registered = ltb::util::detail::set_allocation_hooks_installed();
+
+auto allocate(std::size_t bytes) noexcept -> void* {
+    ltb::util::detail::record_allocation(bytes);
+    return std::malloc(bytes == 0u ? 1u : bytes);
+}
+
+auto allocate_aligned(std::size_t bytes, std::align_val_t alignment) noexcept -> void* {
+    ltb::util::detail::record_allocation(bytes);
+    auto const align = static_cast<std::size_t>(alignment);
+#if defined(_MSC_VER)
+    return ::_aligned_malloc(bytes == 0u ? 1u : bytes, align);
+#else
+    // aligned_alloc requires the size to be a multiple of the alignment
+    auto const rounded = ((bytes == 0u ? 1u : bytes) + align - 1u) / align * align;
+    return std::aligned_alloc(align, rounded);
+#endif
+}
+
+auto allocate_or_throw(std::size_t bytes) -> void* {
+    while (true) {
+        if (auto* memory = allocate(bytes)) {
+            return memory;
+        }
+        if (auto handler = std::get_new_handler()) {
+            handler();
+        } else {
+            throw std::bad_alloc();
+        }
+    }
+}
+
+auto allocate_aligned_or_throw(std::size_t bytes, std::align_val_t alignment) -> void* {
+    while (true) {
+        if (auto* memory = allocate_aligned(bytes, alignment)) {
+            return memory;
+        }
+        if (auto handler = std::get_new_handler()) {
+            handler();
+        } else {
+            throw std::bad_alloc();
+        }
+    }
+}
+
+auto deallocate(void* memory) noexcept -> void {
+    if (memory) {
+        ltb::util::detail::record_deallocation();
+        std::free(memory);
+    }
+}
+
+auto deallocate_aligned(void* memory) noexcept -> void {
+    if (memory) {
+        ltb::util::detail::record_deallocation();
+#if defined(_MSC_VER)
+        ::_aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+} // namespace
+
+auto operator new(std::size_t bytes) -> void* {
+    return allocate_or_throw(bytes);
+}
+
+auto operator new[](std::size_t bytes) -> void* {
+    return allocate_or_throw(bytes);
+}
+
+auto operator new(std::size_t bytes, std::nothrow_t const&) noexcept -> void* {
+    return allocate(bytes);
+}
+
+auto operator new[](std::size_t bytes, std::nothrow_t const&) noexcept -> void* {
+    return allocate(bytes);
+}
+
+auto operator new(std::size_t bytes, std::align_val_t alignment) -> void* {
+    return allocate_aligned_or_throw(bytes, alignment);
+}
+
+auto operator new[](std::size_t bytes, std::align_val_t alignment) -> void* {
+    return allocate_aligned_or_throw(bytes, alignment);
+}
+
+auto operator new(std::size_t bytes, std::align_val_t alignment, std::nothrow_t const&) noexcept -> void* {
+    return allocate_aligned(bytes, alignment);
+}
+
+auto operator new[](std::size_t bytes, std::align_val_t alignment, std::nothrow_t const&) noexcept -> void* {
+    return allocate_aligned(bytes, alignment);
+}
+
+auto operator delete(void* memory) noexcept -> void {
+    deallocate(memory);
+}
+
+auto operator delete[](void* memory) noexcept -> void {
+    deallocate(memory);
+}
+
+auto operator delete(void* memory, std::size_t) noexcept -> void {
+    deallocate(memory);
+}
+
+auto operator delete[](void* memory, std::size_t) noexcept -> void {
+    deallocate(memory);
+}
+
+auto operator delete(void* memory, std::nothrow_t const&) noexcept -> void {
+    deallocate(memory);
+}
+
+auto operator delete[](void* memory, std::nothrow_t const&) noexcept -> void {
+    deallocate(memory);
+}
+
+auto operator delete(void* memory, std::align_val_t) noexcept -> void {
+    deallocate_aligned(memory);
+}
+
+auto operator delete[](void* memory, std::align_val_t) noexcept -> void {
+    deallocate_aligned(memory);
+}
+
+auto operator delete(void* memory, std::size_t, std::align_val_t) noexcept -> void {
+    deallocate_aligned(memory);
+}
+
+auto operator delete[](void* memory, std::size_t, std::align_val_t) noexcept -> void {
+    deallocate_aligned(memory);
+}
+
+auto operator delete(void* memory, std::align_val_t, std::nothrow_t const&) noexcept -> void {
+    deallocate_aligned(memory);
+}
+
+auto operator delete[](void* memory, std::align_val_t, std::nothrow_t const&) noexcept -> void {
+    deallocate_aligned(memory);
+}
@@ -0,0 +1,125 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/allocation_tracker.hpp"
+
+// project
+#include "ltb/util/atomic_data.hpp"
+#include "ltb/util/triple_buffer.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <array>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace ltb::util {
+namespace {
+
+// Trivially constructible and destructible so it can be used at any point in a thread's
+// life, including while other thread_locals are being destroyed.
+thread_local AllocationCounts this_thread_counts = {};
+
+std::atomic_bool hooks_installed = {false};
+
+} // namespace
+
+auto operator-(AllocationCounts const& lhs, AllocationCounts const& rhs) -> AllocationCounts {
+    return {
+        lhs.allocations - rhs.allocations,
+        lhs.deallocations - rhs.deallocations,
+        lhs.bytes - rhs.bytes,
+    };
+}
+
+auto allocation_hooks_installed() -> bool {
+    return hooks_installed.load(std::memory_order_relaxed);
+}
+
+auto this_thread_allocations() -> AllocationCounts {
+    return this_thread_counts;
+}
+
+namespace detail {
+
+auto record_allocation(std::size_t bytes) noexcept -> void {
+    ++this_thread_counts.allocations;
+    this_thread_counts.bytes += bytes;
+}
+
+auto record_deallocation() noexcept -> void {
+    ++this_thread_counts.deallocations;
+}
+
+auto set_allocation_hooks_installed() noexcept -> bool {
+    hooks_installed.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace detail
+
+// The test executable links `LtbUtil::AllocationHooks`.
+TEST_CASE("[ltb][util][allocation_tracker] allocations are counted per thread") {
+    REQUIRE(allocation_hooks_installed());
+
+    auto counts = AllocationCounts{};
+    {
+        auto guard  = count_allocations(counts);
+        auto values = std::vector<int>(100);
+        CHECK(values.size() == 100u);
+    }
+    CHECK(counts.allocations == 1u);
+    CHECK(counts.deallocations == 1u);
+    CHECK(counts.bytes == 100u * sizeof(int));
+
+    // Allocations on other threads aren't counted
+    auto thread = std::thread{};
+    {
+        auto guard = count_allocations(counts);
+        thread     = std::thread([] { auto values = std::vector<int>(100); });
+        thread.join();
+    }
+    // Only the thread's own state is allocated by the counting thread
+    auto const thread_state_allocations = counts.allocations;
+    {
+        auto guard = count_allocations(counts);
+        thread     = std::thread([] {});
+        thread.join();
+    }
+    CHECK(counts.allocations == thread_state_allocations);
+}
+
+TEST_CASE("[ltb][util][allocation_tracker] hot paths can be checked for zero allocations") {
+    REQUIRE(allocation_hooks_installed());
+
+    auto data   = AtomicData<std::array<int, 16>>{};
+    auto buffer = TripleBuffer<std::array<int, 16>>{};
+
+    auto counts = AllocationCounts{};
+    {
+        auto guard = count_allocations(counts);
+        for (auto i = 0; i < 100; ++i) {
+            data.use_safely([i](auto& values) { values[static_cast<std::size_t>(i) % values.size()] = i; });
+            buffer.write(data.load());
+            CHECK(std::accumulate(buffer.read().begin(), buffer.read().end(), 0) >= 0);
+        }
+    }
+    CHECK(counts.allocations == 0u);
+
+    // Large std::function captures don't fit in the small buffer
+    {
+        auto guard    = count_allocations(counts);
+        auto captured = std::array<double, 16>{};
+        auto function = std::function<double()>([captured] { return captured[0]; });
+        CHECK(function() == 0.0);
+    }
+    CHECK(counts.allocations == 1u);
+    CHECK(counts.bytes >= sizeof(std::array<double, 16>));
+}
+
+} // namespace ltb::util
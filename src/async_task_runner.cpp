@@ -6,8 +6,12 @@
 // external
 #include <doctest/doctest.h>
 
+// project
+#include "ltb/util/clock.hpp"
+
 // standard
 #include <array>
+#include <atomic>
 #include <chrono>
 
 namespace {
@@ -52,17 +56,18 @@ TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner calls correct callback
 }
 
 TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner runs tasks in order") {
-    auto task_runner = ltb::util::AsyncTaskRunner<std::chrono::system_clock::time_point>{};
+    using Clock      = ltb::util::ManualClock;
+    auto task_runner = ltb::util::AsyncTaskRunner<Clock::time_point>{};
 
-    // Sleep for a bit then return the current time (this will happen on another thread).
+    // Take 10ms of (virtual) time then return the current time (this will happen on another thread).
     auto task = [] {
-        std::this_thread::sleep_for(10ms);
-        return std::chrono::system_clock::now();
+        Clock::advance(10ms);
+        return Clock::now();
     };
     // There should be no errors because we don't return any
     auto on_error = [](auto&&) { REQUIRE(false); };
 
-    auto times = std::array<std::chrono::system_clock::time_point, 5>{};
+    auto times = std::array<Clock::time_point, 5>{};
 
     task_runner.schedule_task(
         task, [&times](auto result) { times[0] = result; }, on_error);
@@ -86,62 +91,74 @@ TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner runs tasks in order")
     }
 }
 
-TEST_CASE("[ltb][util][async_task_runner][slow] AsyncTaskRunner runs tasks asynchronously") {
-    auto task_runner = ltb::util::AsyncTaskRunner<std::chrono::system_clock::time_point>{};
+TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner runs tasks asynchronously") {
+    using Clock      = ltb::util::ManualClock;
+    auto task_runner = ltb::util::AsyncTaskRunner<Clock::time_point>{};
+
+    auto task_time         = Clock::time_point{};
+    auto invoke_time       = Clock::time_point{};
+    auto before_sleep_time = Clock::time_point{};
+    auto after_sleep_time  = Clock::time_point{};
+    auto after_invoke_time = Clock::time_point{};
 
-    auto task_time         = std::chrono::system_clock::time_point{};
-    auto invoke_time       = std::chrono::system_clock::time_point{};
-    auto before_sleep_time = std::chrono::system_clock::time_point{};
-    auto after_sleep_time  = std::chrono::system_clock::time_point{};
-    auto after_invoke_time = std::chrono::system_clock::time_point{};
+    auto const task_deadline = Clock::now() + 500ms;
 
     task_runner.schedule_task(
-        // This will run on another thread
-        [] {
-            std::this_thread::sleep_for(500ms);
-            return std::chrono::system_clock::now();
+        // This will run on another thread and can't finish until the main thread moves the clock
+        [task_deadline] {
+            ltb::util::sleep_until(task_deadline);
+            return Clock::now();
         },
         // This will run when we call `invoke_next_callback_blocking`
         [&task_time, &invoke_time](auto&& result) {
             task_time   = result;
-            invoke_time = std::chrono::system_clock::now();
+            invoke_time = Clock::now();
         },
         [](auto&&) {
             REQUIRE(false); // There should be no errors because we don't return any
         });
 
-    before_sleep_time = std::chrono::system_clock::now();
-    std::this_thread::sleep_for(1000ms);
-    after_sleep_time = std::chrono::system_clock::now();
+    before_sleep_time = Clock::now();
+    Clock::advance(1000ms);
+    after_sleep_time = Clock::now();
 
     task_runner.invoke_next_callback_blocking();
 
-    after_invoke_time = std::chrono::system_clock::now();
+    after_invoke_time = Clock::now();
 
-    CHECK(before_sleep_time <= task_time);
+    CHECK(before_sleep_time < task_time);
     CHECK(task_time <= after_sleep_time);
     CHECK(after_sleep_time <= invoke_time);
     CHECK(invoke_time <= after_invoke_time);
 }
 
 TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner runs tasks one at a time") {
-    auto task_runner = ltb::util::AsyncTaskRunner<std::chrono::system_clock::time_point>{};
-
-    auto task = [] {
-        std::this_thread::sleep_for(100ms);
-        return std::chrono::system_clock::now();
+    using Clock      = ltb::util::ManualClock;
+    auto task_runner = ltb::util::AsyncTaskRunner<Clock::time_point>{};
+
+    auto const start      = Clock::now();
+    auto       running    = std::atomic_int{0};
+    auto       overlapped = std::atomic_bool{false};
+
+    auto task = [start, &running, &overlapped] {
+        // Nothing can run until the main thread moves the clock
+        ltb::util::sleep_until(start + 1ms);
+        if (++running > 1) {
+            overlapped = true;
+        }
+        Clock::advance(100ms);
+        --running;
+        return Clock::now();
     };
 
-    [[maybe_unused]] auto start = std::chrono::system_clock::now();
-
     task_runner.schedule_task(task);
     task_runner.schedule_task(task);
     task_runner.schedule_task(task);
     task_runner.schedule_task(task);
     task_runner.schedule_task(task);
 
-    [[maybe_unused]] auto end = std::chrono::system_clock::now();
-    CHECK(end - start < 500ms); // Tasks are run asynchronously
+    CHECK(Clock::now() == start); // Tasks are run asynchronously
+    Clock::advance(1ms);
 
     task_runner.invoke_next_callback_blocking();
     task_runner.invoke_next_callback_blocking();
@@ -149,8 +166,8 @@ TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner runs tasks one at a ti
     task_runner.invoke_next_callback_blocking();
     task_runner.invoke_next_callback_blocking();
 
-    end = std::chrono::system_clock::now();
-    CHECK(end - start > 500ms); // Tasks are run one at a time
+    CHECK_FALSE(overlapped); // Tasks are run one at a time
+    CHECK(Clock::now() - start == 501ms);
 }
 
 TEST_CASE("[ltb][util][async_task_runner] AsyncTaskRunner kills task thread on destruction") {
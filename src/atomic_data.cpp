@@ -3,13 +3,19 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #include "ltb/util/atomic_data.hpp"
 
+// project
+#include "ltb/util/ignore.hpp"
+
 // external
 #include <doctest/doctest.h>
 
 // standard
 #include <array>
 #include <chrono>
+#include <memory>
+#include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -139,4 +145,230 @@ TEST_CASE_TEMPLATE("[ltb][util][atomic] interleaved_atomic_data", T, short, int,
     });
 }
 
+TEST_CASE("[ltb][util][atomic] atomic_data_store_load_exchange") {
+    using namespace ltb;
+
+    util::AtomicData<std::string> shared_string("first");
+    CHECK(shared_string.load() == "first");
+
+    shared_string.store("second");
+    CHECK(shared_string.load() == "second");
+
+    CHECK(shared_string.exchange("third") == "second");
+    CHECK(shared_string.load() == "third");
+
+    // Move-only data can be swapped in and out without copies
+    util::AtomicData<std::unique_ptr<int>> shared_pointer;
+    shared_pointer.store(std::make_unique<int>(42));
+
+    auto previous = shared_pointer.exchange(nullptr);
+    REQUIRE(previous != nullptr);
+    CHECK(*previous == 42);
+    shared_pointer.use_safely([](auto const& ptr) { CHECK(ptr == nullptr); });
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_scoped_lock") {
+    using namespace ltb;
+
+    struct SharedData {
+        int              count = 0;
+        std::vector<int> items = {};
+    };
+    util::AtomicData<SharedData> shared_data;
+
+    auto other_thread_saw = 0;
+    auto thread           = std::thread{};
+
+    {
+        auto data = shared_data.scoped_lock();
+        static_assert(std::is_same_v<decltype(data), util::LockedPtr<SharedData>>);
+
+        data->count = 2;
+        data->items.push_back(7);
+        (*data).items.push_back(8);
+
+        // Other threads have to wait until the lock is released
+        thread = std::thread([&] { other_thread_saw = shared_data.load().count; });
+        std::this_thread::sleep_for(10ms);
+
+        // The lock can be handed off without unlocking
+        auto moved_data = std::move(data);
+        CHECK(data.get() == nullptr);
+        CHECK(moved_data->items == std::vector<int>{7, 8});
+
+        moved_data->count = 3;
+    }
+
+    thread.join();
+    CHECK(other_thread_saw == 3);
+
+    auto const_data = std::as_const(shared_data).scoped_lock();
+    static_assert(std::is_same_v<decltype(const_data), util::LockedPtr<SharedData const>>);
+    CHECK(const_data->count == 3);
+}
+
+TEST_CASE("[ltb][util][atomic] use_safely_all") {
+    using namespace ltb;
+
+    util::AtomicData<int>         account_a(500);
+    util::AtomicData<int>         account_b(500);
+    util::AtomicData<std::string> bank_name("Bank");
+
+    auto transfer = [](int amount) {
+        return [amount](int& from, int& to, std::string const& name) {
+            from -= amount;
+            to += amount;
+            return name.size();
+        };
+    };
+
+    // Lock the accounts in opposite orders from two threads. Nested `use_safely`
+    // calls would eventually deadlock here.
+    auto thread = std::thread([&] {
+        for (auto i = 0; i < 10'000; ++i) {
+            util::use_safely_all(transfer(1), account_a, account_b, std::as_const(bank_name));
+        }
+    });
+    for (auto i = 0; i < 10'000; ++i) {
+        util::use_safely_all(transfer(2), account_b, account_a, std::as_const(bank_name));
+    }
+    thread.join();
+
+    auto total = util::use_safely_all([](int a, int b) { return a + b; }, account_a, account_b);
+    CHECK(total == 1000);
+    CHECK(account_a.load() == 500 + 10'000);
+
+    // A single object works too
+    CHECK(util::use_safely_all([](std::string const& name) { return name; }, bank_name) == "Bank");
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_lock_profiling") {
+    using namespace ltb;
+
+    util::AtomicData<int> shared_int(0);
+    shared_int.profile_as("[ltb][util][atomic] profiled int");
+
+    shared_int.use_safely([](int& value) { ++value; });
+    util::ignore(shared_int.wait_to_use_safely(1ms, [](int value) { return value > 0; }, [](int& value) { ++value; }));
+    {
+        auto locked_int = shared_int.scoped_lock();
+        auto moved_int  = std::move(locked_int); // Only counted once
+        ++(*moved_int);
+    }
+
+    auto const& profile = util::lock_profile("[ltb][util][atomic] profiled int");
+    if constexpr (util::lock_profiling_enabled) {
+        CHECK(profile.wait_summary().count == 3u);
+        CHECK(profile.hold_summary().count == 3u);
+    } else {
+        // Profiling compiles away entirely
+        CHECK(profile.wait_summary().count == 0u);
+        CHECK(profile.hold_summary().count == 0u);
+    }
+    CHECK(shared_int.load() == 3);
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_is_cache_line_aligned") {
+    using namespace ltb;
+
+    static_assert(alignof(util::AtomicData<int>) == util::cache_line_size);
+    static_assert(sizeof(util::AtomicData<int>) % util::cache_line_size == 0);
+
+    std::array<util::AtomicData<int>, 4> counters;
+    for (auto const& counter : counters) {
+        CHECK(reinterpret_cast<std::uintptr_t>(&counter) % util::cache_line_size == 0u);
+    }
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_version") {
+    using namespace ltb;
+
+    util::AtomicData<int> shared_int(0);
+    CHECK(shared_int.version() == 0u);
+
+    // Non-const access bumps the version
+    shared_int.store(1);
+    CHECK(shared_int.version() == 1u);
+    shared_int.use_safely([](int& value) { ++value; });
+    util::ignore(shared_int.exchange(5));
+    { auto locked_int = shared_int.scoped_lock(); }
+    CHECK(shared_int.version() == 4u);
+
+    // Read-only access doesn't
+    CHECK(shared_int.load() == 5);
+    std::as_const(shared_int).use_safely([](int const& value) { CHECK(value == 5); });
+    CHECK(shared_int.version() == 4u);
+
+    // Nothing changes so the wait times out
+    CHECK(shared_int.wait_for_change(4u, 10ms) == 4u);
+
+    // Already changed so there is no need to wait
+    CHECK(shared_int.wait_for_change(2u, 0ms) == 4u);
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_timed_out_wait_keeps_version") {
+    using namespace ltb;
+
+    util::AtomicData<int> shared_int(0);
+
+    auto ran = false;
+    CHECK_FALSE(shared_int.wait_to_use_safely(
+        1ms, [](int value) { return value > 0; }, [&ran](int&) { ran = true; }));
+    CHECK_FALSE(ran);
+
+    // The data was never changed so nothing should be woken
+    CHECK(shared_int.version() == 0u);
+    CHECK(shared_int.wait_for_change(0u, 10ms) == 0u);
+
+    // Running the function counts as a change
+    CHECK(shared_int.wait_to_use_safely(
+        1ms, [](int value) { return value == 0; }, [&ran](int&) { ran = true; }));
+    CHECK(ran);
+    CHECK(shared_int.version() == 1u);
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_wait_for_change") {
+    using namespace ltb;
+
+    util::AtomicData<std::vector<int>> shared_values;
+
+    auto const start_version = shared_values.version();
+
+    auto thread = std::thread([&] {
+        std::this_thread::sleep_for(10ms);
+        shared_values.use_safely([](auto& values) { values.push_back(1); });
+    });
+
+    auto const new_version = shared_values.wait_for_change(start_version, 5s);
+    CHECK(new_version == start_version + 1u);
+    CHECK(shared_values.load() == std::vector<int>{1});
+
+    thread.join();
+}
+
+TEST_CASE("[ltb][util][atomic] atomic_data_changes_wake_waiters_without_notify") {
+    using namespace ltb;
+
+    util::AtomicData<int> shared_int(0);
+
+    std::array<std::thread, 8> threads;
+    for (auto& thread : threads) {
+        thread = std::thread([&] {
+            CHECK(shared_int.wait_to_use_safely(5s, [](int value) { return value >= 1; }, [](int& value) { ++value; }));
+        });
+    }
+
+    // No call to 'notify_all' needed
+    shared_int.store(1);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(shared_int.load() == 1 + static_cast<int>(threads.size()));
+
+    // Nobody is waiting so these do nothing
+    shared_int.notify_one();
+    shared_int.notify_all();
+}
+
 } // namespace
@@ -0,0 +1,375 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/benchmark.hpp"
+
+// project
+#include "ltb/util/string.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace ltb::util {
+
+BenchmarkState::BenchmarkState(std::uint64_t iterations) : iterations_(iterations), remaining_(iterations) {}
+
+auto BenchmarkState::keep_running() -> bool {
+    if (!running_ && remaining_ == iterations_) {
+        resume_timing();
+    }
+    if (remaining_ == 0u) {
+        pause_timing();
+        return false;
+    }
+    --remaining_;
+    return true;
+}
+
+auto BenchmarkState::pause_timing() -> void {
+    if (running_) {
+        elapsed_ += std::chrono::duration_cast<Duration>(timer_.elapsed());
+        running_ = false;
+    }
+}
+
+auto BenchmarkState::resume_timing() -> void {
+    if (!running_) {
+        running_ = true;
+        timer_.start();
+    }
+}
+
+auto BenchmarkState::set_ops_per_iteration(std::uint64_t ops) -> void {
+    ops_per_iteration_ = std::max(ops, std::uint64_t{1u});
+}
+
+auto BenchmarkState::iterations() const -> std::uint64_t {
+    return iterations_;
+}
+
+auto BenchmarkState::ops_per_iteration() const -> std::uint64_t {
+    return ops_per_iteration_;
+}
+
+auto BenchmarkState::elapsed() const -> Duration {
+    return elapsed_;
+}
+
+namespace {
+
+struct RegisteredBenchmark {
+    std::string       name;
+    BenchmarkFunction function;
+};
+
+auto registry() -> std::vector<RegisteredBenchmark>& {
+    static auto benchmarks = std::vector<RegisteredBenchmark>{};
+    return benchmarks;
+}
+
+auto run_once(BenchmarkFunction const& function, std::uint64_t iterations) -> BenchmarkState {
+    auto state = BenchmarkState(iterations);
+    function(state);
+    return state;
+}
+
+auto nanos_per_op(BenchmarkState const& state) -> double {
+    auto const ops = static_cast<double>(state.iterations() * state.ops_per_iteration());
+    return to_nanos<double>(state.elapsed()) / ops;
+}
+
+auto median(std::vector<double> const& sorted_values) -> double {
+    auto const middle = sorted_values.size() / 2u;
+    if (sorted_values.size() % 2u == 1u) {
+        return sorted_values[middle];
+    }
+    return (sorted_values[middle - 1u] + sorted_values[middle]) / 2.0;
+}
+
+auto write_result(std::ostream& os, BenchmarkResult const& result) -> void {
+    os << std::left << std::setw(48) << result.name << std::right << std::setw(12) << result.iterations_per_sample
+       << std::setw(12) << result.min_nanos << std::setw(12) << result.median_nanos << std::setw(12)
+       << result.mean_nanos << std::setw(12) << result.stddev_nanos << std::endl;
+}
+
+} // namespace
+
+auto register_benchmark(std::string name, BenchmarkFunction function) -> bool {
+    registry().push_back({std::move(name), std::move(function)});
+    return true;
+}
+
+auto run_benchmark(std::string const& name, BenchmarkFunction const& function, BenchmarkOptions const& options)
+    -> BenchmarkResult {
+    constexpr auto max_iterations = std::uint64_t{1u} << 32u;
+
+    // Warm up caches, branch predictors, CPU frequency, and any lazy initialization for at
+    // least `warm_up_time`, doubling the iteration count while runs are short. None of these
+    // runs are used to estimate the cost of an iteration since the first one may include
+    // one-off costs that would otherwise shrink the number of iterations per sample.
+    auto iterations    = std::uint64_t{1u};
+    auto warm_up_timer = Timer();
+    do {
+        auto const elapsed = run_once(function, iterations).elapsed();
+        if (elapsed < options.sample_time / 10 && iterations < max_iterations) {
+            iterations *= 2u;
+        }
+    } while (warm_up_timer.elapsed() < options.warm_up_time);
+
+    // Estimate how long a single iteration takes from runs long enough to time accurately.
+    auto nanos_per_iter = 0.0;
+    while (true) {
+        auto const elapsed = run_once(function, iterations).elapsed();
+        nanos_per_iter     = to_nanos<double>(elapsed) / static_cast<double>(iterations);
+
+        if (elapsed >= options.sample_time / 10 || iterations >= max_iterations) {
+            break;
+        }
+        iterations *= 2u;
+    }
+
+    auto result                  = BenchmarkResult{};
+    result.name                  = name;
+    result.sample_count          = std::max(options.sample_count, std::uint64_t{1u});
+    result.iterations_per_sample = std::clamp(
+        static_cast<std::uint64_t>(to_nanos<double>(options.sample_time) / std::max(nanos_per_iter, 1e-3)),
+        std::uint64_t{1u},
+        max_iterations);
+
+    auto samples = std::vector<double>{};
+    samples.reserve(result.sample_count);
+    for (auto i = 0u; i < result.sample_count; ++i) {
+        samples.push_back(nanos_per_op(run_once(function, result.iterations_per_sample)));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto const count = samples.size();
+
+    result.min_nanos    = samples.front();
+    result.median_nanos = median(samples);
+    result.mean_nanos   = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(count);
+
+    if (count > 1u) {
+        auto sum_of_squares = 0.0;
+        for (auto sample : samples) {
+            sum_of_squares += (sample - result.mean_nanos) * (sample - result.mean_nanos);
+        }
+        result.stddev_nanos = std::sqrt(sum_of_squares / static_cast<double>(count - 1u));
+    }
+    return result;
+}
+
+auto run_benchmarks(BenchmarkOptions const& options, std::ostream& os) -> std::vector<BenchmarkResult> {
+    // Restored at the end so the caller's stream formatting isn't changed.
+    auto const flags     = os.flags();
+    auto const precision = os.precision();
+
+    os << std::left << std::setw(48) << "benchmark (ns per op)" << std::right << std::setw(12) << "iterations"
+       << std::setw(12) << "min" << std::setw(12) << "median" << std::setw(12) << "mean" << std::setw(12) << "stddev"
+       << '\n';
+    os << std::fixed << std::setprecision(2);
+
+    auto results = std::vector<BenchmarkResult>{};
+    for (auto const& benchmark : registry()) {
+        if (benchmark.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(run_benchmark(benchmark.name, benchmark.function, options));
+        // Flushed so progress is visible while the remaining benchmarks run.
+        write_result(os, results.back());
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+    return results;
+}
+
+auto write_benchmark_json(std::ostream& os, std::vector<BenchmarkResult> const& results) -> void {
+    os << "{\"benchmarks\":[";
+    auto separator = "\n";
+    for (auto const& result : results) {
+        os << separator << "{\"name\":" << to_json_string(result.name)
+           << ",\"iterations_per_sample\":" << result.iterations_per_sample
+           << ",\"sample_count\":" << result.sample_count << ",\"min_ns\":" << result.min_nanos
+           << ",\"median_ns\":" << result.median_nanos << ",\"mean_ns\":" << result.mean_nanos
+           << ",\"stddev_ns\":" << result.stddev_nanos << "}";
+        separator = ",\n";
+    }
+    os << "\n]}\n";
+}
+
+auto benchmark_main(int argc, char const* const* argv) -> int {
+    auto options   = BenchmarkOptions{};
+    auto json_file = std::string{};
+
+    auto const usage = [argv] {
+        std::cerr << "Usage: " << argv[0] << " [--filter <str>] [--samples <n>] [--sample-ms <n>] [--json <file>]"
+                  << std::endl;
+        return 1;
+    };
+
+    for (auto i = 1; i < argc; ++i) {
+        auto const arg      = std::string(argv[i]);
+        auto const has_next = (i + 1 < argc);
+
+        if (arg == "--filter" && has_next) {
+            options.filter = argv[++i];
+        } else if (arg == "--samples" && has_next) {
+            auto const samples = parse_benchmark_count(argv[++i]);
+            if (!samples) {
+                return usage();
+            }
+            options.sample_count = *samples;
+        } else if (arg == "--sample-ms" && has_next) {
+            auto const millis = parse_benchmark_count(argv[++i]);
+            if (!millis || *millis > std::uint64_t(std::numeric_limits<std::int64_t>::max() / 1'000'000)) {
+                return usage();
+            }
+            options.sample_time = duration_millis(static_cast<std::int64_t>(*millis));
+        } else if (arg == "--json" && has_next) {
+            json_file = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+
+    auto const results = run_benchmarks(options, std::cout);
+
+    if (!json_file.empty()) {
+        auto output_stream = std::ofstream(json_file);
+        if (!output_stream.is_open()) {
+            std::cerr << "Failed to open: '" << json_file << "'" << std::endl;
+            return 1;
+        }
+        write_benchmark_json(output_stream, results);
+    }
+    return 0;
+}
+
+auto parse_benchmark_count(std::string const& arg) -> std::optional<std::uint64_t> {
+    auto       value  = std::uint64_t{0u};
+    auto const end    = arg.data() + arg.size();
+    auto const result = std::from_chars(arg.data(), end, value);
+    if (arg.empty() || result.ec != std::errc{} || result.ptr != end || value == 0u) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+TEST_CASE("[ltb][util][benchmark] state only times the loop") {
+    auto state = BenchmarkState(3u);
+    CHECK(state.elapsed() == Duration{});
+
+    auto iterations = 0;
+    while (state.keep_running()) {
+        ++iterations;
+    }
+    CHECK(iterations == 3);
+    CHECK_FALSE(state.keep_running());
+
+    state.set_ops_per_iteration(0u);
+    CHECK(state.ops_per_iteration() == 1u);
+}
+
+TEST_CASE("[ltb][util][benchmark] run, report, and write json") {
+    auto options         = BenchmarkOptions{};
+    options.warm_up_time = duration_millis(1);
+    options.sample_time  = duration_micros(100);
+    options.sample_count = 5u;
+
+    auto const result = run_benchmark(
+        "sum \"numbers\"",
+        [](BenchmarkState& state) {
+            state.set_ops_per_iteration(100u);
+            while (state.keep_running()) {
+                auto sum = 0;
+                for (auto i = 0; i < 100; ++i) {
+                    sum += i;
+                    do_not_optimize(sum);
+                }
+            }
+        },
+        options);
+
+    CHECK(result.sample_count == 5u);
+    CHECK(result.iterations_per_sample >= 1u);
+    CHECK(result.min_nanos > 0.0);
+    CHECK(result.min_nanos <= result.median_nanos);
+    CHECK(result.stddev_nanos >= 0.0);
+
+    auto stream = std::stringstream{};
+    write_benchmark_json(stream, {result});
+    CHECK(stream.str().find(R"({"benchmarks":[)") == 0u);
+    CHECK(stream.str().find(R"("name":"sum \"numbers\"")") != std::string::npos);
+}
+
+TEST_CASE("[ltb][util][benchmark] one-off costs don't decide the iteration count") {
+    auto options         = BenchmarkOptions{};
+    options.warm_up_time = duration_millis(5);
+    options.sample_time  = duration_micros(200);
+    options.sample_count = 3u;
+
+    auto       first_call = true;
+    auto const result     = run_benchmark(
+        "lazy initialization",
+        [&first_call](BenchmarkState& state) {
+            while (state.keep_running()) {
+                if (std::exchange(first_call, false)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+                do_not_optimize(first_call);
+            }
+        },
+        options);
+
+    CHECK(result.iterations_per_sample > 1u);
+}
+
+TEST_CASE("[ltb][util][benchmark] stream formatting is restored") {
+    auto options         = BenchmarkOptions{};
+    options.filter       = "no benchmark has this name";
+    options.sample_count = 1u;
+
+    auto stream = std::ostringstream{};
+    stream << std::left << std::setprecision(4);
+    run_benchmarks(options, stream);
+
+    CHECK(stream.precision() == 4);
+    CHECK((stream.flags() & std::ios::floatfield) == std::ios::fmtflags{});
+    CHECK((stream.flags() & std::ios::adjustfield) == std::ios::left);
+}
+
+TEST_CASE("[ltb][util][benchmark] command line counts are validated") {
+    CHECK(parse_benchmark_count("20") == 20u);
+    CHECK(parse_benchmark_count("18446744073709551615") == ~std::uint64_t{0u});
+    CHECK_FALSE(parse_benchmark_count("").has_value());
+    CHECK_FALSE(parse_benchmark_count("0").has_value());
+    CHECK_FALSE(parse_benchmark_count("-1").has_value());
+    CHECK_FALSE(parse_benchmark_count("ten").has_value());
+    CHECK_FALSE(parse_benchmark_count("10ms").has_value());
+    CHECK_FALSE(parse_benchmark_count("18446744073709551616").has_value());
+
+    // Invalid counts print the usage instead of throwing
+    auto const bad_samples = std::array<char const*, 3>{"bench", "--samples", "many"};
+    CHECK(benchmark_main(int(bad_samples.size()), bad_samples.data()) == 1);
+
+    auto const bad_sample_ms = std::array<char const*, 3>{"bench", "--sample-ms", "99999999999999999"};
+    CHECK(benchmark_main(int(bad_sample_ms.size()), bad_sample_ms.data()) == 1);
+}
+
+} // namespace ltb::util
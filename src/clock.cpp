@@ -0,0 +1,170 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/clock.hpp"
+
+// project
+#include "ltb/util/atomic_data.hpp"
+#include "ltb/util/blocking_queue.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+#if defined(__linux__)
+#include <ctime>
+#endif
+
+// standard
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+
+namespace ltb::util {
+namespace {
+
+using namespace std::chrono_literals;
+
+struct ManualClockState {
+    std::atomic<Duration::rep> now     = {0};
+    std::atomic<std::uint32_t> waiters = {0u};
+    std::mutex                 mutex;
+    std::condition_variable    advanced;
+};
+
+auto manual_clock_state() -> ManualClockState& {
+    // Leaked so the clock can be used during static destruction.
+    static auto* state = new ManualClockState();
+    return *state;
+}
+
+} // namespace
+
+auto CoarseClock::now() noexcept -> time_point {
+#if defined(CLOCK_MONOTONIC_COARSE)
+    auto time = timespec{};
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+    return time_point(duration_seconds(time.tv_sec) + duration_nanos(time.tv_nsec));
+#else
+    return time_point(std::chrono::duration_cast<duration>(SteadyClock::now().time_since_epoch()));
+#endif
+}
+
+auto CoarseClock::resolution() -> Duration {
+#if defined(CLOCK_MONOTONIC_COARSE)
+    auto resolution = timespec{};
+    ::clock_getres(CLOCK_MONOTONIC_COARSE, &resolution);
+    return duration_seconds(resolution.tv_sec) + duration_nanos(resolution.tv_nsec);
+#else
+    return std::chrono::duration_cast<Duration>(SteadyClock::duration(1));
+#endif
+}
+
+auto ManualClock::now() noexcept -> time_point {
+    return time_point(duration(manual_clock_state().now.load(std::memory_order_acquire)));
+}
+
+auto ManualClock::advance(Duration amount) -> void {
+    if (amount < Duration::zero()) {
+        throw std::invalid_argument("ManualClock can't go backwards");
+    }
+    auto& state = manual_clock_state();
+    {
+        // Locked so a sleeping thread can't miss the notification between checking the time and waiting.
+        auto const lock = std::lock_guard(state.mutex);
+        state.now.fetch_add(amount.count(), std::memory_order_acq_rel);
+    }
+    state.advanced.notify_all();
+}
+
+auto ManualClock::sleep_until(time_point deadline) -> void {
+    auto const waiter = detail::ManualClockWaiter{};
+    auto&      state  = manual_clock_state();
+    auto       lock   = std::unique_lock(state.mutex);
+    state.advanced.wait(lock, [deadline] { return now() >= deadline; });
+}
+
+auto ManualClock::sleep_for(Duration amount) -> void {
+    sleep_until(now() + amount);
+}
+
+auto ManualClock::waiting_threads() -> std::uint32_t {
+    return manual_clock_state().waiters.load(std::memory_order_acquire);
+}
+
+namespace detail {
+
+ManualClockWaiter::ManualClockWaiter() {
+    manual_clock_state().waiters.fetch_add(1u, std::memory_order_acq_rel);
+}
+
+ManualClockWaiter::~ManualClockWaiter() {
+    manual_clock_state().waiters.fetch_sub(1u, std::memory_order_acq_rel);
+}
+
+} // namespace detail
+
+TEST_CASE("[ltb][util][clock] coarse clock tracks the steady clock") {
+    CHECK(CoarseClock::resolution() > Duration::zero());
+    CHECK(CoarseClock::resolution() < 100ms);
+
+    auto const start = CoarseClock::now();
+    std::this_thread::sleep_for(20ms);
+    auto const elapsed = CoarseClock::now() - start;
+    CHECK(elapsed >= 20ms - CoarseClock::resolution());
+}
+
+TEST_CASE("[ltb][util][clock] manual clock only moves when advanced") {
+    auto const start = ManualClock::now();
+    std::this_thread::sleep_for(1ms);
+    CHECK(ManualClock::now() == start);
+
+    ManualClock::advance(250ms);
+    CHECK(ManualClock::now() - start == 250ms);
+    CHECK_THROWS_AS(ManualClock::advance(-1ms), std::invalid_argument);
+
+    auto const deadline = ManualClock::now() + 1h;
+    auto       woke_at  = ManualClock::time_point{};
+    auto       sleeper  = std::thread([deadline, &woke_at] {
+        sleep_until(deadline);
+        woke_at = ManualClock::now();
+    });
+    ManualClock::advance(30min);
+    ManualClock::advance(30min);
+    sleeper.join();
+    CHECK(woke_at - start == 1h + 250ms);
+}
+
+TEST_CASE("[ltb][util][clock] timeouts can be tested with the manual clock") {
+    auto queue = BlockingQueue<int>{};
+    auto data  = AtomicData<int>{0};
+
+    auto popped      = std::optional<int>{};
+    auto used        = true;
+    auto finished    = std::atomic_int{0};
+    auto pop_thread  = std::thread([&] {
+        popped = queue.pop_front<ManualClock>(1h);
+        ++finished;
+    });
+    auto wait_thread = std::thread([&] {
+        used = data.wait_to_use_safely<ManualClock>(1h, [](int value) { return value > 0; }, [](int&) {});
+        ++finished;
+    });
+
+    // Both deadlines are computed before the clock moves.
+    while (ManualClock::waiting_threads() < 2u) {
+        std::this_thread::yield();
+    }
+
+    // Neither times out, however long they wait in real time, until the clock passes an hour.
+    ManualClock::advance(59min);
+    std::this_thread::sleep_for(5ms);
+    CHECK(finished == 0);
+    ManualClock::advance(1min);
+
+    pop_thread.join();
+    wait_thread.join();
+    CHECK_FALSE(popped.has_value());
+    CHECK_FALSE(used);
+}
+
+} // namespace ltb::util
@@ -0,0 +1,163 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/concurrent_map.hpp"
+
+// project
+#include "ltb/util/hash_utils.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// Uuid needs boost, which is optional.
+#if __has_include(<boost/uuid/uuid.hpp>)
+#define LTB_TEST_UUID_KEYS
+#include "ltb/util/uuid.hpp"
+#endif
+
+// standard
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace ltb;
+
+struct GridCell {
+    int x = 0;
+    int y = 0;
+
+    auto operator==(GridCell const& other) const -> bool { return x == other.x && y == other.y; }
+};
+
+struct GridCellHash {
+    auto operator()(GridCell const& cell) const -> std::size_t {
+        return util::hash_combine(util::hash_combine(0u, cell.x), cell.y);
+    }
+};
+
+TEST_CASE("[ltb][util][concurrent_map] find, insert_or_assign, and erase") {
+    auto map = util::ConcurrentMap<std::string, int>{};
+
+    CHECK(map.size() == 0u);
+    CHECK_FALSE(map.find("one").has_value());
+
+    CHECK(map.insert_or_assign("one", 1));
+    CHECK(map.insert_or_assign("two", 2));
+    CHECK_FALSE(map.insert_or_assign("one", 11)); // assigned, not inserted
+
+    CHECK(map.size() == 2u);
+    CHECK(map.contains("two"));
+    CHECK(map.find("one") == 11);
+
+    CHECK(map.erase("one"));
+    CHECK_FALSE(map.erase("one"));
+    CHECK_FALSE(map.contains("one"));
+    CHECK(map.size() == 1u);
+
+    map.clear();
+    CHECK(map.size() == 0u);
+}
+
+TEST_CASE("[ltb][util][concurrent_map] keys with a hash_combine hash") {
+    auto map = util::ConcurrentMap<GridCell, int, GridCellHash>{};
+
+    for (auto x = -10; x < 10; ++x) {
+        for (auto y = -10; y < 10; ++y) {
+            CHECK(map.insert_or_assign({x, y}, x * 100 + y));
+        }
+    }
+    CHECK(map.size() == 400u);
+
+    // Swapped coordinates hash differently so they are separate keys
+    CHECK(map.find({2, 3}) == 203);
+    CHECK(map.find({3, 2}) == 302);
+    CHECK_FALSE(map.find({10, 0}).has_value());
+
+    CHECK(map.erase({2, 3}));
+    CHECK_FALSE(map.contains({2, 3}));
+    CHECK(map.contains({3, 2}));
+    CHECK(map.size() == 399u);
+}
+
+#if defined(LTB_TEST_UUID_KEYS)
+TEST_CASE("[ltb][util][concurrent_map] Uuid keys") {
+    struct Tag {};
+    using Id = util::Uuid<Tag>;
+
+    // Uses `std::hash<ltb::util::Uuid<T>>` from uuid.hpp
+    auto map = util::ConcurrentMap<Id, int>{};
+
+    auto generator = boost::uuids::random_generator{};
+    auto ids       = std::vector<Id>{};
+    for (auto i = 0; i < 100; ++i) {
+        ids.emplace_back(generator());
+        CHECK(map.insert_or_assign(ids.back(), i));
+    }
+    CHECK(map.size() == 100u);
+    CHECK_FALSE(map.insert_or_assign(ids.front(), -1)); // assigned, not inserted
+
+    CHECK(map.find(ids.front()) == -1);
+    CHECK(map.find(Id::from_string(ids[42].to_string())) == 42);
+    CHECK_FALSE(map.find(Id::nil_id()).has_value());
+
+    CHECK(map.erase(ids[42]));
+    CHECK_FALSE(map.erase(ids[42]));
+    CHECK_FALSE(map.contains(ids[42]));
+    CHECK(map.size() == 99u);
+}
+#endif
+
+TEST_CASE("[ltb][util][concurrent_map] compute_if_absent only computes once") {
+    auto map = util::ConcurrentMap<GridCell, std::string, GridCellHash>{};
+
+    auto computations = std::atomic_int{0};
+    auto make_value   = [&computations] {
+        ++computations;
+        return std::string("computed");
+    };
+
+    auto threads = std::array<std::thread, 8>{};
+    for (auto& thread : threads) {
+        thread = std::thread([&] {
+            for (auto x = 0; x < 10; ++x) {
+                for (auto y = 0; y < 10; ++y) {
+                    CHECK(map.compute_if_absent({x, y}, make_value) == "computed");
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(computations == 100);
+    CHECK(map.size() == 100u);
+    CHECK(map.find({3, 7}) == "computed");
+}
+
+TEST_CASE("[ltb][util][concurrent_map] parallel for_each") {
+    auto map = util::ConcurrentMap<int, int, std::hash<int>, std::equal_to<int>, 4u>{};
+    for (auto i = 0; i < 1000; ++i) {
+        map.insert_or_assign(i, i);
+    }
+
+    auto visited = std::atomic_int{0};
+    map.for_each([&visited](int const& key, int& value) {
+        value = key * 2;
+        ++visited;
+    });
+    CHECK(visited == 1000);
+
+    // Single threaded should work the same way
+    auto sum = 0;
+    map.for_each([&sum](int const&, int const& value) { sum += value; }, 1u);
+    CHECK(sum == 999 * 1000);
+
+    CHECK_THROWS_AS(map.for_each([](int const&, int&) { throw std::runtime_error("thrown on any thread"); }),
+                    std::runtime_error);
+}
+
+} // namespace
@@ -3,70 +3,156 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #include "ltb/util/error.hpp"
 
+// project
+#include "ltb/util/generic_guard.hpp"
+#include "ltb/util/result.hpp"
+
 // external
 #include <doctest/doctest.h>
 
 // standard
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
 #include <string>
 
 namespace ltb::util {
 
-SourceLocation::SourceLocation(std::filesystem::path file, int line) : filename(std::move(file)), line_number(line) {}
+Error::Error(SourceLocation source_location, Severity severity, std::string_view error_message)
+    : source_location_(source_location), severity_(severity), message_size_(0u) {
+    if (error_stack_traces_enabled()) {
+        // Skip this constructor so the trace starts where the error was made.
+        stack_trace_ = std::make_shared<StackTrace const>(StackTrace::capture(1u));
+    }
+    assign_message(error_message);
+}
 
-namespace {
+Error::~Error() {
+    release_message();
+}
 
-///
-/// \brief Prepend the file and line number to the message if they were specified.
-///
-auto create_debug_message(SourceLocation const& source_location, std::string const& error_message) -> std::string {
-    std::string result = "[";
+Error::Error(Error const& other)
+    : source_location_(other.source_location_),
+      severity_(other.severity_),
+      message_size_(0u),
+      stack_trace_(other.stack_trace_) {
+    assign_message(other.error_message());
+}
 
-    if (source_location.line_number >= 0) {
-        result += ':' + std::to_string(source_location.line_number);
+auto Error::operator=(Error const& other) -> Error& {
+    if (this != &other) {
+        *this = Error(other);
     }
-
-    result += "] " + error_message;
-    return result;
+    return *this;
 }
 
-} // namespace
-
-Error::~Error() = default;
+Error::Error(Error&& other) noexcept
+    : source_location_(other.source_location_), severity_(other.severity_), message_size_(0u) {
+    *this = std::move(other);
+}
 
-Error::Error(SourceLocation source_location, Severity severity, std::string error_message)
-    : source_location_(std::move(source_location)),
-      severity_(severity),
-      error_message_(std::move(error_message)),
-      debug_message_(create_debug_message(source_location_, error_message_)) {}
+auto Error::operator=(Error&& other) noexcept -> Error& {
+    if (this != &other) {
+        release_message();
+        source_location_ = other.source_location_;
+        severity_        = other.severity_;
+        message_size_    = other.message_size_;
+        stack_trace_     = std::move(other.stack_trace_);
+
+        if (other.is_inline()) {
+            std::memcpy(inline_message_, other.inline_message_, message_size_);
+        } else {
+            // Take the heap message and leave `other` with an empty inline one.
+            heap_message_       = other.heap_message_;
+            other.message_size_ = 0u;
+        }
+    }
+    return *this;
+}
 
 auto Error::severity() const -> Error::Severity const& {
     return severity_;
 }
 
-auto Error::error_message() const -> std::string const& {
-    return error_message_;
+auto Error::error_message() const -> std::string_view {
+    return {message_data(), message_size_};
 }
 
-auto Error::debug_error_message() const -> std::string const& {
-    return debug_message_;
+auto Error::debug_error_message() const -> std::string {
+    std::string result = "[";
+
+    if (source_location_.line_number >= 0) {
+        result += ':' + std::to_string(source_location_.line_number);
+    }
+
+    result += "] ";
+    result += error_message();
+
+    if (stack_trace_) {
+        result += '\n';
+        result += stack_trace_->to_string();
+    }
+    return result;
 }
 
 auto Error::source_location() const -> SourceLocation const& {
     return source_location_;
 }
 
-auto Error::append_message(Error const& error, std::string const& message) -> Error {
-    return Error(error.source_location_, error.severity_, error.error_message_ + " " + message);
+auto Error::stack_trace() const -> StackTrace const* {
+    return stack_trace_.get();
+}
+
+auto Error::append_message(Error const& error, std::string_view message) -> Error {
+    auto full_message = std::string(error.error_message());
+    full_message += ' ';
+    full_message += message;
+
+    // Keep the original error's stack trace rather than one from here.
+    auto result         = Error(error.source_location_, error.severity_, full_message);
+    result.stack_trace_ = error.stack_trace_;
+    return result;
 }
 
 auto Error::operator==(Error const& other) const -> bool {
-    return debug_message_ == other.debug_message_;
+    return source_location_.line_number == other.source_location_.line_number
+        && error_message() == other.error_message();
 }
 
 auto Error::operator!=(Error const& other) const -> bool {
     return !(this->operator==(other));
 }
 
+auto Error::is_inline() const -> bool {
+    return message_size_ <= inline_message_capacity;
+}
+
+auto Error::message_data() const -> char const* {
+    return is_inline() ? inline_message_ : heap_message_;
+}
+
+auto Error::assign_message(std::string_view message) -> void {
+    if (message.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("Error message is too long");
+    }
+    message_size_ = static_cast<std::uint32_t>(message.size());
+
+    if (is_inline()) {
+        std::memcpy(inline_message_, message.data(), message.size());
+    } else {
+        heap_message_ = new char[message.size()];
+        std::memcpy(heap_message_, message.data(), message.size());
+    }
+}
+
+auto Error::release_message() -> void {
+    if (!is_inline()) {
+        delete[] heap_message_;
+        message_size_ = 0u;
+    }
+}
+
 } // namespace ltb::util
 
 namespace {
@@ -80,6 +166,12 @@ namespace {
     return "[" + prefix + this_file.string() + ":" + std::to_string(line_number) + "] " + error_message;
 }
 
+/// \brief Sets whether errors capture stack traces until the returned guard is destroyed.
+auto stack_traces_enabled(bool enabled) {
+    auto const previous = ltb::util::set_error_stack_traces_enabled(enabled);
+    return ltb::util::make_guard([] {}, [previous] { ltb::util::set_error_stack_traces_enabled(previous); });
+}
+
 } // namespace
 
 TEST_CASE("[ltb][util][error] check error helpers") {
@@ -93,3 +185,70 @@ TEST_CASE("[ltb][util][error] check warning helpers") {
     CHECK(LTB_MAKE_WARNING("blarg") == LTB_MAKE_WARNING("blarg"));
     CHECK(LTB_MAKE_WARNING("not so bad").severity() == ltb::util::Error::Severity::Warning);
 }
+
+TEST_CASE("[ltb][util][error] errors are small") {
+    CHECK(sizeof(ltb::util::Error) <= 64u);
+    CHECK(sizeof(ltb::util::Result<int>) <= 72u);
+}
+
+TEST_CASE("[ltb][util][error] short and long messages survive copies and moves") {
+    auto const stack_traces_off = stack_traces_enabled(false);
+    auto const short_message = std::string("Short");
+    auto const long_message  = std::string(ltb::util::Error::inline_message_capacity + 1u, 'x');
+
+    for (auto const& message : {short_message, long_message, std::string()}) {
+        auto error = LTB_MAKE_ERROR(message);
+        CHECK(error.error_message() == message);
+        auto const line = std::to_string(error.source_location().line_number);
+        CHECK(error.debug_error_message() == "[:" + line + "] " + message);
+
+        auto copy = error;
+        CHECK(copy == error);
+        CHECK(copy.error_message() == message);
+
+        auto moved = std::move(copy);
+        CHECK(moved == error);
+
+        copy = moved;
+        CHECK(copy.error_message() == message);
+
+        copy = LTB_MAKE_WARNING("Replaced");
+        CHECK(copy.error_message() == "Replaced");
+
+        copy = std::move(moved);
+        CHECK(copy.error_message() == message);
+        CHECK(copy.severity() == ltb::util::Error::Severity::Error);
+    }
+}
+
+TEST_CASE("[ltb][util][error] appended messages can move to the heap") {
+    auto const error    = LTB_MAKE_ERROR("Failed to open file");
+    auto const appended = ltb::util::Error::append_message(error, "'/a/path/that/is/longer/than/the/inline/buffer'");
+    CHECK(appended.error_message() == "Failed to open file '/a/path/that/is/longer/than/the/inline/buffer'");
+    CHECK(appended.source_location().line_number == error.source_location().line_number);
+    CHECK(std::string(appended.source_location().filename) == error.source_location().filename);
+}
+
+TEST_CASE("[ltb][util][error] stack traces are optional") {
+    {
+        auto const stack_traces_off = stack_traces_enabled(false);
+        auto const error            = LTB_MAKE_ERROR("No trace");
+        CHECK(error.stack_trace() == nullptr);
+        CHECK(error.debug_error_message().find('\n') == std::string::npos);
+    }
+
+    auto const stack_traces_on = stack_traces_enabled(true);
+    auto const error           = LTB_MAKE_ERROR("Traced");
+    REQUIRE(error.stack_trace() != nullptr);
+    CHECK_FALSE(error.stack_trace()->empty());
+
+    // Symbolized when printed
+    auto const line = std::to_string(error.source_location().line_number);
+    CHECK(error.debug_error_message().rfind("[:" + line + "] Traced\n#0 ", 0) == 0u);
+
+    // Copies and appended messages share the original trace
+    auto const copy     = error;
+    auto const appended = ltb::util::Error::append_message(error, "again");
+    CHECK(copy.stack_trace() == error.stack_trace());
+    CHECK(appended.stack_trace() == error.stack_trace());
+}
@@ -0,0 +1,98 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/error_code.hpp"
+
+// project
+#include "ltb/util/async_task_runner.hpp"
+#include "ltb/util/result.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace {
+
+using namespace ltb;
+
+enum class ParseError : std::uint8_t {
+    Empty,
+    NotANumber,
+};
+
+constexpr auto error_code_message(ParseError code) -> char const* {
+    switch (code) {
+        case ParseError::Empty:
+            return "Input is empty";
+        case ParseError::NotANumber:
+            return "Input is not a number";
+    }
+    return "Unknown parse error";
+}
+
+auto parse_digit(std::string const& input) -> util::Result<int, util::ErrorCode<ParseError>> {
+    if (input.empty()) {
+        return tl::make_unexpected(ParseError::Empty);
+    }
+    if (input.size() > 1u || input[0] < '0' || input[0] > '9') {
+        return tl::make_unexpected(ParseError::NotANumber);
+    }
+    return input[0] - '0';
+}
+
+TEST_CASE("[ltb][util][error_code] error codes fit in a register") {
+    CHECK(sizeof(util::ErrorCode<ParseError>) == sizeof(ParseError));
+    CHECK(sizeof(util::Result<int, util::ErrorCode<ParseError>>) <= sizeof(std::uint64_t));
+}
+
+TEST_CASE("[ltb][util][error_code] error codes have static messages") {
+    constexpr auto code = util::ErrorCode(ParseError::NotANumber);
+    static_assert(code.value() == 1u);
+    static_assert(code.error_message() == "Input is not a number");
+    static_assert(code == ParseError::NotANumber);
+    static_assert(code != ParseError::Empty);
+
+    CHECK(code.severity() == util::Error::Severity::Error);
+    CHECK(code.debug_error_message() == "[code 1] Input is not a number");
+}
+
+TEST_CASE("[ltb][util][error_code] error codes can be returned in a Result") {
+    CHECK(parse_digit("7").value() == 7);
+    CHECK(parse_digit("").error() == ParseError::Empty);
+    CHECK(parse_digit("seven").error() == ParseError::NotANumber);
+}
+
+TEST_CASE("[ltb][util][error_code] error codes convert to errors with a source location") {
+    auto const error = parse_digit("").map_error([](auto code) { return LTB_MAKE_ERROR_FROM_CODE(code); }).error();
+    CHECK(error.error_message() == "Input is empty");
+    CHECK(error.source_location().line_number == __LINE__ - 2);
+    CHECK(std::string(error.source_location().filename) == __FILE__);
+
+    auto const warning
+        = util::to_error({__FILE__, __LINE__}, util::ErrorCode(ParseError::Empty), util::Error::Severity::Warning);
+    CHECK(warning.severity() == util::Error::Severity::Warning);
+}
+
+TEST_CASE("[ltb][util][error_code] AsyncTaskRunner passes error codes to the error callback") {
+    auto task_runner = util::AsyncTaskRunner<int, util::ErrorCode<ParseError>>{};
+
+    auto value      = 0;
+    auto error      = std::optional<util::ErrorCode<ParseError>>{};
+    auto on_success = [&value](int result) { value = result; };
+    auto on_error   = [&error](util::ErrorCode<ParseError>&& code) { error = code; };
+
+    task_runner.schedule_task([] { return parse_digit("4"); }, on_success, on_error);
+    task_runner.schedule_task([] { return parse_digit("four"); }, on_success, on_error);
+    task_runner.invoke_next_callback_blocking();
+    task_runner.invoke_next_callback_blocking();
+
+    CHECK(value == 4);
+    REQUIRE(error.has_value());
+    CHECK(*error == ParseError::NotANumber);
+}
+
+} // namespace
@@ -0,0 +1,258 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/error_sink.hpp"
+
+// project
+#include "ltb/util/clock.hpp"
+#include "ltb/util/hash_utils.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ltb::util {
+namespace {
+
+using namespace std::chrono_literals;
+
+/// \brief How often queued errors are grouped, so samples are passed on soon after they happen.
+constexpr auto drain_interval = duration_millis(10);
+
+struct GroupKey {
+    std::string_view filename;
+    int              line_number;
+    Error::Severity  severity;
+
+    explicit GroupKey(Error const& error)
+        : filename(error.source_location().filename != nullptr ? error.source_location().filename : ""),
+          line_number(error.source_location().line_number),
+          severity(error.severity()) {}
+
+    auto operator==(GroupKey const& other) const -> bool {
+        return line_number == other.line_number && severity == other.severity && filename == other.filename;
+    }
+};
+
+struct GroupKeyHash {
+    auto operator()(GroupKey const& key) const -> std::size_t {
+        return hash_combine(hash_combine(std::hash<std::string_view>{}(key.filename), key.line_number), key.severity);
+    }
+};
+
+struct Group {
+    std::optional<Error> first_sample;
+    std::uint64_t        count = 0u;
+};
+
+} // namespace
+
+AggregatingErrorSink::AggregatingErrorSink(ErrorCallback downstream,
+                                           std::size_t   max_samples,
+                                           std::size_t   capacity,
+                                           Duration      report_interval)
+    : downstream_(std::move(downstream)),
+      max_samples_(max_samples),
+      report_interval_(report_interval),
+      errors_(capacity),
+      reporter_thread_([this] { report_loop(); }) {}
+
+AggregatingErrorSink::~AggregatingErrorSink() {
+    {
+        auto const lock = std::lock_guard(mutex_);
+        stopping_       = true;
+    }
+    wake_reporter_.notify_one();
+    reporter_thread_.join();
+}
+
+auto AggregatingErrorSink::submit(Error error) -> void {
+    if (!errors_.try_push(std::optional<Error>(std::move(error)))) {
+        dropped_.fetch_add(1u, std::memory_order_relaxed);
+    }
+}
+
+auto AggregatingErrorSink::callback() -> ErrorCallback {
+    return [this](Error error) { submit(std::move(error)); };
+}
+
+auto AggregatingErrorSink::flush() -> void {
+    auto       lock   = std::unique_lock(mutex_);
+    auto const target = ++flushes_requested_;
+    wake_reporter_.notify_one();
+    flushed_.wait(lock, [this, target] { return flushes_completed_ >= target; });
+}
+
+auto AggregatingErrorSink::dropped() const -> std::uint64_t {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+auto AggregatingErrorSink::report_loop() -> void {
+    auto groups           = std::unordered_map<GroupKey, Group, GroupKeyHash>{};
+    auto reported_dropped = std::uint64_t{0u};
+    auto next_report      = SteadyClock::now() + report_interval_;
+
+    auto lock = std::unique_lock(mutex_);
+    while (true) {
+        wake_reporter_.wait_for(lock, std::min(drain_interval, report_interval_), [this] {
+            return stopping_ || flushes_requested_ != flushes_completed_;
+        });
+        auto const stopping     = stopping_;
+        auto const flush_target = flushes_requested_;
+        lock.unlock();
+
+        while (auto error = errors_.try_pop()) {
+            auto& group = groups[GroupKey(**error)];
+            if (++group.count <= max_samples_) {
+                if (!group.first_sample) {
+                    group.first_sample = **error;
+                }
+                invoke_if_non_null(downstream_, std::move(**error));
+            }
+        }
+
+        auto const now = SteadyClock::now();
+        if (stopping || flush_target != flushes_completed_ || now >= next_report) {
+            for (auto const& [key, group] : groups) {
+                if (group.count <= max_samples_) {
+                    continue;
+                }
+                auto const more = std::to_string(group.count - max_samples_);
+                if (group.first_sample) {
+                    auto summary = Error::append_message(*group.first_sample, "(repeated " + more + " more times)");
+                    invoke_if_non_null(downstream_, std::move(summary));
+                } else {
+                    // Only happens if `max_samples` is zero.
+                    auto const location = SourceLocation(key.filename.data(), key.line_number);
+                    auto       summary  = Error(location, key.severity, "Repeated " + more + " times");
+                    invoke_if_non_null(downstream_, std::move(summary));
+                }
+            }
+            groups.clear();
+
+            auto const dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped) {
+                invoke_if_non_null(downstream_,
+                                   LTB_MAKE_WARNING("Dropped " + std::to_string(dropped - reported_dropped)
+                                                    + " errors because the error sink was full"));
+                reported_dropped = dropped;
+            }
+            next_report = now + report_interval_;
+        }
+
+        lock.lock();
+        flushes_completed_ = flush_target;
+        flushed_.notify_all();
+
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+namespace {
+
+auto make_error(Error::Severity severity, std::string const& message) -> Error {
+    return Error({__FILE__, __LINE__}, severity, message);
+}
+
+auto repeated_count(std::string_view message) -> std::uint64_t {
+    auto const start = message.find("(repeated ");
+    return start == std::string_view::npos ? 0u : std::stoull(std::string(message.substr(start + 10u)));
+}
+
+} // namespace
+
+TEST_CASE("[ltb][util][error_sink] bursts are collapsed into samples and a count") {
+    auto messages = std::vector<std::string>{};
+    auto sink     = AggregatingErrorSink([&messages](Error error) { messages.emplace_back(error.error_message()); },
+                                     2u,
+                                     1024u,
+                                     duration_seconds(10));
+
+    for (auto i = 0; i < 100; ++i) {
+        sink.submit(make_error(Error::Severity::Error, "Connection refused " + std::to_string(i)));
+    }
+    sink.submit(make_error(Error::Severity::Warning, "Retrying")); // Same line, different severity
+    sink.flush();
+
+    CHECK(messages
+          == std::vector<std::string>{
+              "Connection refused 0",
+              "Connection refused 1",
+              "Retrying",
+              "Connection refused 0 (repeated 98 more times)",
+          });
+
+    // Counts start again after each report
+    messages.clear();
+    sink.submit(make_error(Error::Severity::Error, "Connection refused again"));
+    sink.flush();
+    CHECK(messages == std::vector<std::string>{"Connection refused again"});
+}
+
+TEST_CASE("[ltb][util][error_sink] reporting threads never block") {
+    auto samples = std::uint64_t{0u};
+    auto counted = std::uint64_t{0u};
+    auto dropped = std::vector<std::string>{};
+
+    auto const downstream = [&](Error error) {
+        if (error.severity() == Error::Severity::Warning) {
+            dropped.emplace_back(error.error_message());
+        } else if (auto const count = repeated_count(error.error_message()); count > 0u) {
+            counted += count;
+        } else {
+            ++samples;
+        }
+    };
+    auto sink = AggregatingErrorSink(downstream, 3u, 8u, duration_seconds(10));
+
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < 4; ++t) {
+        threads.emplace_back([callback = sink.callback()] {
+            for (auto i = 0; i < 1000; ++i) {
+                invoke_if_non_null(callback, LTB_MAKE_ERROR("Timed out"));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    sink.flush();
+
+    // Every error is either passed on, counted in a summary, or dropped.
+    CHECK(samples == 3u);
+    CHECK(samples + counted + sink.dropped() == 4000u);
+    CHECK(dropped.size() == (sink.dropped() > 0u ? 1u : 0u));
+}
+
+TEST_CASE("[ltb][util][error_sink] summaries are sent when the interval ends") {
+    auto summaries = std::atomic_int{0};
+    auto sink      = AggregatingErrorSink(
+        [&summaries](Error const& error) {
+            if (repeated_count(error.error_message()) > 0u) {
+                ++summaries;
+            }
+        },
+        1u,
+        64u,
+        duration_millis(20));
+
+    for (auto i = 0; i < 2; ++i) {
+        sink.submit(LTB_MAKE_ERROR("Disk full"));
+    }
+
+    auto const start = SteadyClock::now();
+    while (summaries == 0 && SteadyClock::now() - start < 10s) {
+        std::this_thread::sleep_for(1ms);
+    }
+    CHECK(summaries == 1);
+}
+
+} // namespace ltb::util
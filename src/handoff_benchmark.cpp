@@ -0,0 +1,278 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/handoff_benchmark.hpp"
+
+// project
+#include "ltb/util/blocking_queue.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+// standard
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace ltb::util {
+namespace {
+
+struct RegisteredHandoff {
+    std::string     name;
+    HandoffFunction function;
+};
+
+auto registry() -> std::vector<RegisteredHandoff>& {
+    static auto handoffs = std::vector<RegisteredHandoff>{};
+    return handoffs;
+}
+
+struct BurstPattern {
+    std::uint32_t size;
+    Duration      pause;
+};
+
+/// \brief A continuous stream and short bursts separated by idle time (so consumers go to sleep).
+constexpr auto burst_patterns = std::array<BurstPattern, 2>{
+    BurstPattern{1u, Duration::zero()},
+    BurstPattern{64u, std::chrono::duration_cast<Duration>(std::chrono::microseconds(200))},
+};
+
+auto write_csv_field(std::ostream& os, std::string const& field) -> void {
+    if (field.find_first_of(",\"\n") == std::string::npos) {
+        os << field;
+        return;
+    }
+    os << '"';
+    for (auto c : field) {
+        if (c == '"') {
+            os << '"';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+} // namespace
+
+auto process_cpu_time() -> Duration {
+#if defined(_WIN32)
+    auto creation_time = FILETIME{};
+    auto exit_time     = FILETIME{};
+    auto kernel_time   = FILETIME{};
+    auto user_time     = FILETIME{};
+    ::GetProcessTimes(::GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time);
+
+    auto to_100_nanos = [](FILETIME const& time) {
+        return (std::uint64_t{time.dwHighDateTime} << 32u) | std::uint64_t{time.dwLowDateTime};
+    };
+    return duration_nanos((to_100_nanos(kernel_time) + to_100_nanos(user_time)) * 100u);
+#else
+    auto time = timespec{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return duration_seconds(time.tv_sec) + duration_nanos(time.tv_nsec);
+#endif
+}
+
+auto register_handoff_benchmark(std::string name, HandoffFunction function) -> bool {
+    registry().push_back({std::move(name), std::move(function)});
+    return true;
+}
+
+auto handoff_thread_counts(std::uint32_t max_threads) -> std::vector<std::uint32_t> {
+    max_threads = std::max(max_threads, 1u);
+
+    auto counts = std::vector<std::uint32_t>{};
+    for (auto count = 1u; count < max_threads; count *= 2u) {
+        counts.push_back(count);
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+auto run_handoff_sweep(HandoffSweepOptions const& options, std::ostream& csv) -> std::vector<HandoffResult> {
+    write_handoff_csv_header(csv);
+
+    auto const thread_counts = handoff_thread_counts(options.max_threads);
+
+    auto results = std::vector<HandoffResult>{};
+    for (auto const& handoff : registry()) {
+        if (handoff.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        for (auto const producers : thread_counts) {
+            for (auto const consumers : thread_counts) {
+                for (auto const payload_bytes : handoff_payload_sizes) {
+                    for (auto const& burst : burst_patterns) {
+                        auto config                  = HandoffConfig{};
+                        config.producers             = producers;
+                        config.consumers             = consumers;
+                        config.payload_bytes         = payload_bytes;
+                        config.burst_size            = burst.size;
+                        config.burst_pause           = burst.pause;
+                        config.messages_per_producer = options.messages_per_producer;
+
+                        results.push_back(handoff.function(config));
+                        results.back().name = handoff.name;
+                        // Flushed so progress is visible while the remaining configurations run.
+                        write_handoff_csv_row(csv, results.back());
+                        csv.flush();
+                    }
+                }
+            }
+        }
+    }
+    return results;
+}
+
+auto write_handoff_csv_header(std::ostream& os) -> void {
+    os << "name,producers,consumers,payload_bytes,burst_size,burst_pause_ns,messages,ops_per_second,"
+          "p50_handoff_ns,p99_handoff_ns,max_handoff_ns,cpu_ns_per_op\n";
+}
+
+auto write_handoff_csv_row(std::ostream& os, HandoffResult const& result) -> void {
+    write_csv_field(os, result.name);
+    os << ',' << result.config.producers << ',' << result.config.consumers << ',' << result.config.payload_bytes
+       << ',' << result.config.burst_size << ',' << to_nanos<std::int64_t>(result.config.burst_pause) << ','
+       << result.messages << ',' << static_cast<std::uint64_t>(result.ops_per_second) << ','
+       << to_nanos<std::int64_t>(result.p50_handoff) << ',' << to_nanos<std::int64_t>(result.p99_handoff) << ','
+       << to_nanos<std::int64_t>(result.max_handoff) << ',' << result.cpu_nanos_per_op << '\n';
+}
+
+auto handoff_sweep_main(int argc, char const* const* argv) -> int {
+    auto options  = HandoffSweepOptions{};
+    auto csv_file = std::string{};
+
+    auto const usage = [argv] {
+        std::cerr << "Usage: " << argv[0] << " [--filter <str>] [--max-threads <n>] [--messages <n>] [--csv <file>]"
+                  << std::endl;
+        return 1;
+    };
+
+    for (auto i = 1; i < argc; ++i) {
+        auto const arg      = std::string(argv[i]);
+        auto const has_next = (i + 1 < argc);
+
+        if (arg == "--filter" && has_next) {
+            options.filter = argv[++i];
+        } else if (arg == "--max-threads" && has_next) {
+            auto const max_threads = parse_benchmark_count(argv[++i]);
+            if (!max_threads || *max_threads > std::numeric_limits<std::uint32_t>::max()) {
+                return usage();
+            }
+            options.max_threads = static_cast<std::uint32_t>(*max_threads);
+        } else if (arg == "--messages" && has_next) {
+            auto const messages = parse_benchmark_count(argv[++i]);
+            if (!messages) {
+                return usage();
+            }
+            options.messages_per_producer = *messages;
+        } else if (arg == "--csv" && has_next) {
+            csv_file = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+
+    if (csv_file.empty()) {
+        run_handoff_sweep(options, std::cout);
+        return 0;
+    }
+
+    auto output_stream = std::ofstream(csv_file);
+    if (!output_stream.is_open()) {
+        std::cerr << "Failed to open: '" << csv_file << "'" << std::endl;
+        return 1;
+    }
+    run_handoff_sweep(options, output_stream);
+    return 0;
+}
+
+TEST_CASE("[ltb][util][handoff_benchmark] thread counts") {
+    CHECK(handoff_thread_counts(0u) == std::vector<std::uint32_t>{1u});
+    CHECK(handoff_thread_counts(1u) == std::vector<std::uint32_t>{1u});
+    CHECK(handoff_thread_counts(4u) == std::vector<std::uint32_t>{1u, 2u, 4u});
+    CHECK(handoff_thread_counts(6u) == std::vector<std::uint32_t>{1u, 2u, 4u, 6u});
+}
+
+TEST_CASE("[ltb][util][handoff_benchmark] command line counts are validated") {
+    // Larger than a uint32_t, so it can't be a thread count
+    auto const bad_threads = std::array<char const*, 3>{"--handoff-sweep", "--max-threads", "4294967296"};
+    CHECK(handoff_sweep_main(int(bad_threads.size()), bad_threads.data()) == 1);
+
+    auto const bad_messages = std::array<char const*, 3>{"--handoff-sweep", "--messages", "1e6"};
+    CHECK(handoff_sweep_main(int(bad_messages.size()), bad_messages.data()) == 1);
+}
+
+TEST_CASE("[ltb][util][handoff_benchmark] process cpu time increases with work") {
+    auto const start = process_cpu_time();
+
+    auto sum = 0.0;
+    for (auto i = 0; i < 10'000'000; ++i) {
+        sum += static_cast<double>(i);
+        do_not_optimize(sum);
+    }
+    CHECK(process_cpu_time() > start);
+}
+
+TEST_CASE("[ltb][util][handoff_benchmark] run handoff through a blocking queue") {
+    auto config                  = HandoffConfig{};
+    config.producers             = 3u;
+    config.consumers             = 2u;
+    config.payload_bytes         = 128u;
+    config.burst_size            = 10u;
+    config.burst_pause           = duration_micros(10);
+    config.messages_per_producer = 1'000u;
+
+    auto const result = visit_handoff_payload(config.payload_bytes, [&config](auto payload_bytes) {
+        using Message = HandoffMessage<decltype(payload_bytes)::value>;
+
+        auto queue = BlockingQueue<Message>{};
+        return run_handoff<Message>(
+            "blocking \"queue\", 128",
+            config,
+            [&queue](Message message) { queue.push_back(std::move(message)); },
+            [&queue] { return queue.pop_front(); });
+    });
+
+    CHECK(result.messages == 3'000u);
+    CHECK(result.ops_per_second > 0.0);
+    CHECK(result.p50_handoff <= result.p99_handoff);
+    CHECK(result.p99_handoff <= result.max_handoff);
+    CHECK(result.cpu_nanos_per_op > 0.0);
+
+    CHECK_THROWS_AS(visit_handoff_payload(7u, [](auto) { return HandoffResult{}; }), std::invalid_argument);
+
+    auto stream = std::stringstream{};
+    write_handoff_csv_header(stream);
+    write_handoff_csv_row(stream, result);
+
+    auto header = std::string{};
+    auto row    = std::string{};
+    std::getline(stream, header);
+    std::getline(stream, row);
+    CHECK(header.find("name,producers,consumers,payload_bytes,") == 0u);
+    CHECK(row.find(R"("blocking ""queue"", 128",3,2,128,10,10000,3000,)") == 0u);
+}
+
+TEST_CASE("[ltb][util][handoff_benchmark] sweep only writes the header when nothing matches") {
+    auto options   = HandoffSweepOptions{};
+    options.filter = "no handoff has this name";
+
+    auto stream = std::stringstream{};
+    CHECK(run_handoff_sweep(options, stream).empty());
+
+    auto const csv = stream.str();
+    CHECK(csv.find("name,producers") == 0u);
+    CHECK(std::count(csv.begin(), csv.end(), '\n') == 1);
+}
+
+} // namespace ltb::util
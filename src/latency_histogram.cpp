@@ -0,0 +1,319 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/latency_histogram.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+namespace ltb::util {
+namespace detail {
+namespace {
+
+constexpr auto sub_bucket_count      = std::uint64_t{1u} << LatencyHistogram::sub_bucket_bits;
+constexpr auto half_sub_bucket_count = sub_bucket_count / 2u;
+
+auto bit_width(std::uint64_t value) -> unsigned {
+#if defined(__GNUC__) || defined(__clang__)
+    return value == 0u ? 0u : 64u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    auto width = 0u;
+    while (value > 0u) {
+        value >>= 1u;
+        ++width;
+    }
+    return width;
+#endif
+}
+
+} // namespace
+
+auto latency_bucket_index(std::uint64_t nanos) -> std::size_t {
+    if (nanos < sub_bucket_count) {
+        return static_cast<std::size_t>(nanos);
+    }
+    // Keep the top `sub_bucket_bits` bits of the value. The highest is always set so
+    // only the remaining bits are needed to pick a bucket within the power of 2.
+    auto const shift    = bit_width(nanos) - LatencyHistogram::sub_bucket_bits;
+    auto const mantissa = nanos >> shift;
+    return static_cast<std::size_t>(sub_bucket_count + (shift - 1u) * half_sub_bucket_count
+                                    + (mantissa - half_sub_bucket_count));
+}
+
+auto latency_bucket_upper_bound(std::size_t index) -> std::uint64_t {
+    if (index < sub_bucket_count) {
+        return index;
+    }
+    auto const shift    = (index - sub_bucket_count) / half_sub_bucket_count + 1u;
+    auto const mantissa = (index - sub_bucket_count) % half_sub_bucket_count + half_sub_bucket_count;
+    auto const lower    = std::uint64_t{mantissa} << shift;
+    return lower + ((std::uint64_t{1u} << shift) - 1u);
+}
+
+} // namespace detail
+
+namespace {
+
+auto to_histogram_nanos(Duration duration) -> std::uint64_t {
+    return static_cast<std::uint64_t>(std::max(to_nanos<std::int64_t>(duration), std::int64_t{0}));
+}
+
+auto atomic_min(std::atomic<std::uint64_t>& current, std::uint64_t value) -> void {
+    auto previous = current.load(std::memory_order_relaxed);
+    while (value < previous && !current.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+auto atomic_max(std::atomic<std::uint64_t>& current, std::uint64_t value) -> void {
+    auto previous = current.load(std::memory_order_relaxed);
+    while (value > previous && !current.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+auto LatencyHistogram::record(Duration duration) -> void {
+    auto const nanos = to_histogram_nanos(duration);
+
+    buckets_[detail::latency_bucket_index(nanos)].fetch_add(1u, std::memory_order_relaxed);
+    count_.fetch_add(1u, std::memory_order_relaxed);
+    total_.fetch_add(nanos, std::memory_order_relaxed);
+    atomic_min(min_, nanos);
+    atomic_max(max_, nanos);
+}
+
+auto LatencyHistogram::merge(LatencyHistogram const& other) -> void {
+    for (auto i = 0u; i < bucket_count; ++i) {
+        if (auto const bucket = other.buckets_[i].load(std::memory_order_relaxed); bucket > 0u) {
+            buckets_[i].fetch_add(bucket, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    total_.fetch_add(other.total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    atomic_min(min_, other.min_.load(std::memory_order_relaxed));
+    atomic_max(max_, other.max_.load(std::memory_order_relaxed));
+}
+
+auto LatencyHistogram::reset() -> void {
+    for (auto& bucket : buckets_) {
+        bucket.store(0u, std::memory_order_relaxed);
+    }
+    count_.store(0u, std::memory_order_relaxed);
+    total_.store(0u, std::memory_order_relaxed);
+    min_.store(~std::uint64_t{0u}, std::memory_order_relaxed);
+    max_.store(0u, std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::count() const -> std::uint64_t {
+    return count_.load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::percentile(double percentile) const -> Duration {
+    // Sum the buckets instead of using `count_` so concurrent recording can't leave the rank unreachable.
+    auto total = std::uint64_t{0u};
+    for (auto const& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0u) {
+        return Duration{};
+    }
+
+    auto const fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    auto const rank = std::max(std::uint64_t{1u}, static_cast<std::uint64_t>(std::ceil(fraction * double(total))));
+
+    auto seen = std::uint64_t{0u};
+    for (auto i = 0u; i < bucket_count; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            auto const upper_bound = detail::latency_bucket_upper_bound(i);
+            auto const min         = min_.load(std::memory_order_relaxed);
+            auto const max         = max_.load(std::memory_order_relaxed);
+            return duration_nanos(std::clamp(upper_bound, std::min(min, max), max));
+        }
+    }
+    return duration_nanos(max_.load(std::memory_order_relaxed));
+}
+
+auto LatencyHistogram::summary() const -> Summary {
+    auto summary  = Summary{};
+    summary.count = count();
+    if (summary.count == 0u) {
+        return summary;
+    }
+    summary.total = duration_nanos(total_.load(std::memory_order_relaxed));
+    summary.min   = duration_nanos(min_.load(std::memory_order_relaxed));
+    summary.p50   = percentile(50.0);
+    summary.p90   = percentile(90.0);
+    summary.p99   = percentile(99.0);
+    summary.p999  = percentile(99.9);
+    summary.max   = duration_nanos(max_.load(std::memory_order_relaxed));
+    return summary;
+}
+
+namespace {
+
+struct LatencyHistogramRegistry {
+    std::mutex                                               mutex;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+};
+
+auto registry() -> LatencyHistogramRegistry& {
+    // Leaked on purpose so histograms can still be recorded and dumped during static destruction.
+    static auto* registry = new LatencyHistogramRegistry();
+    return *registry;
+}
+
+} // namespace
+
+auto latency_histogram(std::string const& name) -> LatencyHistogram& {
+    auto&      histograms = registry();
+    auto const lock       = std::lock_guard(histograms.mutex);
+
+    auto& histogram = histograms.histograms[name];
+    if (!histogram) {
+        histogram = std::make_unique<LatencyHistogram>();
+    }
+    return *histogram;
+}
+
+auto dump_latency_histograms(std::ostream& os) -> void {
+    auto&      histograms = registry();
+    auto const lock       = std::lock_guard(histograms.mutex);
+
+    // Restored at the end so the caller's stream formatting isn't changed.
+    auto const flags     = os.flags();
+    auto const precision = os.precision();
+
+    os << std::left << std::setw(40) << "histogram" << std::right << std::setw(10) << "count" << std::setw(12)
+       << "p50 (us)" << std::setw(12) << "p90 (us)" << std::setw(12) << "p99 (us)" << std::setw(12) << "p99.9 (us)"
+       << std::setw(12) << "max (us)" << '\n';
+
+    os << std::fixed << std::setprecision(3);
+    for (auto const& [name, histogram] : histograms.histograms) {
+        auto const summary = histogram->summary();
+        os << std::left << std::setw(40) << name << std::right << std::setw(10) << summary.count << std::setw(12)
+           << to_micros<double>(summary.p50) << std::setw(12) << to_micros<double>(summary.p90) << std::setw(12)
+           << to_micros<double>(summary.p99) << std::setw(12) << to_micros<double>(summary.p999) << std::setw(12)
+           << to_micros<double>(summary.max) << '\n';
+    }
+    os << std::flush;
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+TEST_CASE("[ltb][util][latency_histogram] buckets have bounded relative error") {
+    CHECK(detail::latency_bucket_index(0u) == 0u);
+    CHECK(detail::latency_bucket_index(127u) == 127u);
+    CHECK(detail::latency_bucket_index(128u) == 128u);
+    CHECK(detail::latency_bucket_index(~std::uint64_t{0u}) == LatencyHistogram::bucket_count - 1u);
+    CHECK(detail::latency_bucket_upper_bound(LatencyHistogram::bucket_count - 1u) == ~std::uint64_t{0u});
+
+    for (auto value = std::uint64_t{1u}; value < (std::uint64_t{1u} << 62u); value = value * 3u + 1u) {
+        auto const index = detail::latency_bucket_index(value);
+        auto const upper = detail::latency_bucket_upper_bound(index);
+        CHECK(upper >= value);
+        CHECK(double(upper - value) / double(value) <= 1.0 / 64.0);
+
+        // Buckets are contiguous
+        if (index > 0u) {
+            CHECK(detail::latency_bucket_upper_bound(index - 1u) < value);
+        }
+    }
+}
+
+TEST_CASE("[ltb][util][latency_histogram] percentiles") {
+    using namespace std::chrono_literals;
+
+    auto histogram = LatencyHistogram{};
+    CHECK(histogram.summary().count == 0u);
+    CHECK(histogram.percentile(50.0) == 0ns);
+
+    for (auto i = 1; i <= 1000; ++i) {
+        histogram.record(duration_micros(i));
+    }
+
+    auto const summary = histogram.summary();
+    CHECK(summary.count == 1000u);
+    CHECK(summary.total == duration_micros(500 * 1001));
+    CHECK(summary.min == 1us);
+    CHECK(summary.max == 1000us);
+    CHECK(to_micros<double>(summary.p50) == doctest::Approx(500.0).epsilon(1.0 / 64.0));
+    CHECK(to_micros<double>(summary.p90) == doctest::Approx(900.0).epsilon(1.0 / 64.0));
+    CHECK(to_micros<double>(summary.p99) == doctest::Approx(990.0).epsilon(1.0 / 64.0));
+    CHECK(to_micros<double>(summary.p999) == doctest::Approx(999.0).epsilon(1.0 / 64.0));
+    CHECK(histogram.percentile(100.0) == 1000us);
+
+    // Small values are exact
+    histogram.reset();
+    histogram.record(5ns);
+    histogram.record(7ns);
+    CHECK(histogram.percentile(50.0) == 5ns);
+    CHECK(histogram.percentile(100.0) == 7ns);
+}
+
+TEST_CASE("[ltb][util][latency_histogram] recording and merging from several threads") {
+    using namespace std::chrono_literals;
+
+    auto shared     = LatencyHistogram{};
+    auto merged     = LatencyHistogram{};
+    auto per_thread = std::array<LatencyHistogram, 4>{};
+
+    auto threads = std::array<std::thread, 4>{};
+    for (auto t = 0u; t < threads.size(); ++t) {
+        threads[t] = std::thread([&, t] {
+            for (auto i = 0; i < 1000; ++i) {
+                shared.record(duration_nanos(i + 1000 * int(t)));
+                per_thread[t].record(duration_nanos(i + 1000 * int(t)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto const& histogram : per_thread) {
+        merged.merge(histogram);
+    }
+
+    CHECK(shared.count() == 4000u);
+    CHECK(merged.count() == 4000u);
+    CHECK(merged.summary().min == 0ns);
+    CHECK(merged.summary().max == 3999ns);
+    CHECK(merged.percentile(50.0) == shared.percentile(50.0));
+    CHECK(merged.percentile(99.9) == shared.percentile(99.9));
+}
+
+TEST_CASE("[ltb][util][latency_histogram] named histograms are shared and dumped") {
+    using namespace std::chrono_literals;
+
+    auto& histogram = latency_histogram("[ltb][util][latency_histogram] test");
+    CHECK(&histogram == &latency_histogram("[ltb][util][latency_histogram] test"));
+
+    histogram.record(3ms);
+
+    auto stream = std::stringstream{};
+    dump_latency_histograms(stream);
+    CHECK(stream.str().find("[ltb][util][latency_histogram] test") != std::string::npos);
+    CHECK(stream.str().find("3000.000") != std::string::npos);
+
+    // The caller's formatting is restored
+    stream = std::stringstream{};
+    stream << std::scientific << std::left << std::setprecision(4);
+    dump_latency_histograms(stream);
+    CHECK(stream.precision() == 4);
+    CHECK((stream.flags() & std::ios::floatfield) == std::ios::scientific);
+    CHECK((stream.flags() & std::ios::adjustfield) == std::ios::left);
+}
+
+} // namespace ltb::util
@@ -0,0 +1,154 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/lock_profiler.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+
+namespace ltb::util {
+
+LockProfile::LockProfile(std::string name) : name_(std::move(name)) {}
+
+auto LockProfile::record_wait(Duration duration) -> void {
+    waits_.record(duration);
+}
+
+auto LockProfile::record_hold(Duration duration) -> void {
+    holds_.record(duration);
+}
+
+auto LockProfile::name() const -> std::string const& {
+    return name_;
+}
+
+auto LockProfile::wait_summary() const -> Summary {
+    return waits_.summary();
+}
+
+auto LockProfile::hold_summary() const -> Summary {
+    return holds_.summary();
+}
+
+namespace {
+
+struct LockProfileRegistry {
+    std::mutex                                          mutex;
+    std::map<std::string, std::unique_ptr<LockProfile>> profiles;
+};
+
+auto registry() -> LockProfileRegistry& {
+    // Leaked on purpose so profiles can still be recorded and dumped during static destruction.
+    static auto* registry = new LockProfileRegistry();
+    return *registry;
+}
+
+auto write_summary(std::ostream& os, LockProfile::Summary const& summary) -> void {
+    os << std::setw(10) << summary.count << std::setw(14) << to_millis<double>(summary.total) << std::setw(12)
+       << to_micros<double>(summary.p50) << std::setw(12) << to_micros<double>(summary.p90) << std::setw(12)
+       << to_micros<double>(summary.p99) << std::setw(12) << to_micros<double>(summary.p999) << std::setw(12)
+       << to_micros<double>(summary.max);
+}
+
+} // namespace
+
+auto lock_profile(std::string const& name) -> LockProfile& {
+    auto&      profiles = registry();
+    auto const lock     = std::lock_guard(profiles.mutex);
+
+    auto& profile = profiles.profiles[name];
+    if (!profile) {
+        profile = std::make_unique<LockProfile>(name);
+    }
+    return *profile;
+}
+
+auto dump_lock_profiles(std::ostream& os) -> void {
+    auto&      profiles = registry();
+    auto const lock     = std::lock_guard(profiles.mutex);
+
+    // Restored at the end so the caller's stream formatting isn't changed.
+    auto const flags     = os.flags();
+    auto const precision = os.precision();
+
+    os << std::left << std::setw(40) << "lock" << std::right << std::setw(6) << "" << std::setw(10) << "count"
+       << std::setw(14) << "total (ms)" << std::setw(12) << "p50 (us)" << std::setw(12) << "p90 (us)" << std::setw(12)
+       << "p99 (us)" << std::setw(12) << "p99.9 (us)" << std::setw(12) << "max (us)" << '\n';
+
+    os << std::fixed << std::setprecision(3);
+    for (auto const& [name, profile] : profiles.profiles) {
+        os << std::left << std::setw(40) << name << std::right << std::setw(6) << "wait";
+        write_summary(os, profile->wait_summary());
+        os << '\n' << std::setw(46) << "hold";
+        write_summary(os, profile->hold_summary());
+        os << '\n';
+    }
+    os << std::flush;
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+TEST_CASE("[ltb][util][lock_profiler] summaries have the same percentiles as latency histograms") {
+    using namespace std::chrono_literals;
+
+    auto profile = LockProfile("[ltb][util][lock_profiler] percentiles");
+    CHECK(profile.wait_summary().count == 0u);
+    CHECK(profile.wait_summary().max == 0ns);
+
+    for (auto i = 0; i < 1994; ++i) {
+        profile.record_wait(100ns);
+    }
+    for (auto i = 0; i < 5; ++i) {
+        profile.record_wait(5us);
+    }
+    profile.record_wait(1ms);
+
+    auto const summary = profile.wait_summary();
+    CHECK(summary.count == 2000u);
+    CHECK(summary.total == 1994 * 100ns + 25us + 1ms);
+    CHECK(summary.min == 100ns);
+    CHECK(summary.p50 == 100ns);
+    CHECK(summary.p90 == 100ns);
+    CHECK(summary.p99 == 100ns);
+    CHECK(to_micros<double>(summary.p999) == doctest::Approx(5.0).epsilon(1.0 / 64.0));
+    CHECK(summary.max == 1ms);
+
+    CHECK(profile.hold_summary().count == 0u);
+}
+
+TEST_CASE("[ltb][util][lock_profiler] named profiles are shared and dumped") {
+    using namespace std::chrono_literals;
+
+    auto& profile = lock_profile("[ltb][util][lock_profiler] test");
+    CHECK(&profile == &lock_profile("[ltb][util][lock_profiler] test"));
+    CHECK(profile.name() == "[ltb][util][lock_profiler] test");
+
+    profile.record_wait(2ms);
+    profile.record_hold(3ms);
+    CHECK(profile.wait_summary().count == 1u);
+    CHECK(profile.hold_summary().max == 3ms);
+
+    auto stream = std::stringstream{};
+    dump_lock_profiles(stream);
+    CHECK(stream.str().find("[ltb][util][lock_profiler] test") != std::string::npos);
+
+    // The caller's formatting is restored
+    stream = std::stringstream{};
+    stream << std::left << std::setprecision(2);
+    dump_lock_profiles(stream);
+    CHECK((stream.flags() & std::ios::adjustfield) == std::ios::left);
+    stream.str("");
+    stream << 1.2345;
+    CHECK(stream.str() == "1.2");
+}
+
+} // namespace ltb::util
@@ -0,0 +1,320 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/metrics.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace ltb::util {
+namespace {
+
+/// \brief `name{labels}` or just `name` if there are no labels.
+auto write_sample_name(std::ostream& os, std::string const& name, std::string const& labels) -> void {
+    os << name;
+    if (!labels.empty()) {
+        os << '{' << labels << '}';
+    }
+}
+
+auto write_bucket(std::ostream&      os,
+                  std::string const& name,
+                  std::string const& labels,
+                  std::string const& upper_bound,
+                  std::uint64_t      cumulative_count) -> void {
+    os << name << "_bucket{" << labels << (labels.empty() ? "" : ",") << "le=\"" << upper_bound << "\"} "
+       << cumulative_count << '\n';
+}
+
+auto to_string(double value) -> std::string {
+    auto stream = std::ostringstream{};
+    stream.precision(15);
+    stream << value;
+    return stream.str();
+}
+
+} // namespace
+
+auto Counter::value() const -> std::uint64_t {
+    auto total = std::uint64_t{0u};
+    for (auto const& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+auto Gauge::set(std::int64_t value) -> void {
+    add(value - this->value());
+}
+
+auto Gauge::value() const -> std::int64_t {
+    auto total = std::int64_t{0};
+    for (auto const& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram(std::vector<double> upper_bounds)
+    : upper_bounds_(std::move(upper_bounds)),
+      // One extra bucket for values above the last bound.
+      lines_per_shard_((upper_bounds_.size() + detail::MetricCountLine::size) / detail::MetricCountLine::size),
+      count_lines_(std::make_unique<detail::MetricCountLine[]>(lines_per_shard_ * metric_shard_count)) {
+    std::sort(upper_bounds_.begin(), upper_bounds_.end());
+}
+
+auto Histogram::observe(double value) -> void {
+    auto const shard  = detail::this_thread_metric_shard();
+    auto const bucket = static_cast<std::size_t>(std::lower_bound(upper_bounds_.begin(), upper_bounds_.end(), value)
+                                                 - upper_bounds_.begin());
+    count(shard, bucket).fetch_add(1u, std::memory_order_relaxed);
+
+    // Only this thread (and any others sharing the shard) updates the sum so this rarely loops.
+    auto& shard_sum = sums_[shard].value;
+    auto  sum       = shard_sum.load(std::memory_order_relaxed);
+    while (!shard_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+    }
+}
+
+auto Histogram::snapshot() const -> Snapshot {
+    auto snapshot              = Snapshot{};
+    snapshot.upper_bounds      = upper_bounds_;
+    snapshot.cumulative_counts = std::vector<std::uint64_t>(upper_bounds_.size() + 1u, 0u);
+
+    for (auto shard = 0u; shard < metric_shard_count; ++shard) {
+        for (auto i = 0u; i < snapshot.cumulative_counts.size(); ++i) {
+            snapshot.cumulative_counts[i] += count(shard, i).load(std::memory_order_relaxed);
+        }
+        snapshot.sum += sums_[shard].value.load(std::memory_order_relaxed);
+    }
+    for (auto i = 1u; i < snapshot.cumulative_counts.size(); ++i) {
+        snapshot.cumulative_counts[i] += snapshot.cumulative_counts[i - 1u];
+    }
+    snapshot.count = snapshot.cumulative_counts.back();
+    return snapshot;
+}
+
+auto Histogram::count(std::size_t shard, std::size_t bucket) const -> std::atomic<std::uint64_t>& {
+    auto& line = count_lines_[shard * lines_per_shard_ + bucket / detail::MetricCountLine::size];
+    return line.counts[bucket % detail::MetricCountLine::size];
+}
+
+auto default_latency_buckets() -> std::vector<double> {
+    return {1e-6, 1e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 10.0};
+}
+
+auto MetricsRegistry::counter(std::string const& name, std::string const& help, std::string const& labels)
+    -> Counter& {
+    auto const lock = std::lock_guard(mutex_);
+    auto&      item = family(name, help, Type::Counter).counters[labels];
+    if (!item) {
+        item = std::make_unique<Counter>();
+    }
+    return *item;
+}
+
+auto MetricsRegistry::gauge(std::string const& name, std::string const& help, std::string const& labels) -> Gauge& {
+    auto const lock = std::lock_guard(mutex_);
+    auto&      item = family(name, help, Type::Gauge).gauges[labels];
+    if (!item) {
+        item = std::make_unique<Gauge>();
+    }
+    return *item;
+}
+
+auto MetricsRegistry::histogram(std::string const&  name,
+                                std::string const&  help,
+                                std::vector<double> upper_bounds,
+                                std::string const&  labels) -> Histogram& {
+    auto const lock = std::lock_guard(mutex_);
+    auto&      item = family(name, help, Type::Histogram).histograms[labels];
+    if (!item) {
+        item = std::make_unique<Histogram>(std::move(upper_bounds));
+    }
+    return *item;
+}
+
+auto MetricsRegistry::write_prometheus(std::ostream& os) const -> void {
+    auto const lock = std::lock_guard(mutex_);
+
+    for (auto const& [name, family] : families_) {
+        if (!family.help.empty()) {
+            os << "# HELP " << name << ' ' << family.help << '\n';
+        }
+
+        switch (family.type) {
+            case Type::Counter:
+                os << "# TYPE " << name << " counter\n";
+                for (auto const& [labels, counter] : family.counters) {
+                    write_sample_name(os, name, labels);
+                    os << ' ' << counter->value() << '\n';
+                }
+                break;
+
+            case Type::Gauge:
+                os << "# TYPE " << name << " gauge\n";
+                for (auto const& [labels, gauge] : family.gauges) {
+                    write_sample_name(os, name, labels);
+                    os << ' ' << gauge->value() << '\n';
+                }
+                break;
+
+            case Type::Histogram:
+                os << "# TYPE " << name << " histogram\n";
+                for (auto const& [labels, histogram] : family.histograms) {
+                    auto const snapshot = histogram->snapshot();
+                    for (auto i = 0u; i < snapshot.upper_bounds.size(); ++i) {
+                        auto const upper_bound = to_string(snapshot.upper_bounds[i]);
+                        write_bucket(os, name, labels, upper_bound, snapshot.cumulative_counts[i]);
+                    }
+                    write_bucket(os, name, labels, "+Inf", snapshot.count);
+                    write_sample_name(os, name + "_sum", labels);
+                    os << ' ' << to_string(snapshot.sum) << '\n';
+                    write_sample_name(os, name + "_count", labels);
+                    os << ' ' << snapshot.count << '\n';
+                }
+                break;
+        }
+    }
+}
+
+auto MetricsRegistry::write_prometheus(std::filesystem::path const& filename) const -> Result<void> {
+    auto output_stream = std::ofstream(filename);
+
+    if (!output_stream.is_open()) {
+        return tl::make_unexpected(LTB_MAKE_ERROR("Failed to open: '" + filename.string() + "'"));
+    }
+
+    write_prometheus(output_stream);
+
+    if (!output_stream.flush()) {
+        return tl::make_unexpected(LTB_MAKE_ERROR("Failed to write: '" + filename.string() + "'"));
+    }
+    return success();
+}
+
+auto MetricsRegistry::to_prometheus_string() const -> std::string {
+    auto stream = std::ostringstream{};
+    write_prometheus(stream);
+    return stream.str();
+}
+
+auto MetricsRegistry::family(std::string const& name, std::string const& help, Type type) -> Family& {
+    auto [iter, inserted] = families_.try_emplace(name, Family{type, help, {}, {}, {}});
+    if (!inserted && iter->second.type != type) {
+        throw std::invalid_argument("Metric '" + name + "' already exists with a different type");
+    }
+    return iter->second;
+}
+
+auto metrics() -> MetricsRegistry& {
+    // Leaked on purpose so metrics can be updated during static destruction.
+    static auto* registry = new MetricsRegistry();
+    return *registry;
+}
+
+TEST_CASE("[ltb][util][metrics] counters and gauges sum their shards") {
+    auto registry = MetricsRegistry{};
+    auto& counter = registry.counter("tasks_total", "Tasks run");
+    auto& gauge   = registry.gauge("queue_depth", "Queued tasks");
+
+    CHECK(&registry.counter("tasks_total", "Tasks run") == &counter);
+    CHECK_THROWS_AS(registry.gauge("tasks_total", ""), std::invalid_argument);
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 8; ++i) {
+        threads.emplace_back([&counter, &gauge] {
+            for (auto j = 0; j < 10'000; ++j) {
+                counter.increment();
+                gauge.add(2);
+                gauge.subtract(1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(counter.value() == 80'000u);
+    CHECK(gauge.value() == 80'000);
+
+    gauge.set(-5);
+    CHECK(gauge.value() == -5);
+}
+
+TEST_CASE("[ltb][util][metrics] histogram buckets are cumulative") {
+    auto histogram = Histogram({1.0, 0.1, 10.0});
+    for (auto value : {0.05, 0.1, 0.5, 2.0, 20.0, 30.0}) {
+        histogram.observe(value);
+    }
+
+    auto const snapshot = histogram.snapshot();
+    CHECK(snapshot.upper_bounds == std::vector<double>{0.1, 1.0, 10.0});
+    CHECK(snapshot.cumulative_counts == std::vector<std::uint64_t>{2u, 3u, 4u, 6u});
+    CHECK(snapshot.count == 6u);
+    CHECK(snapshot.sum == doctest::Approx(52.65));
+}
+
+TEST_CASE("[ltb][util][metrics] histograms sum their shards") {
+    // More buckets than fit in one cache line, so each shard spans several.
+    auto histogram = Histogram(default_latency_buckets());
+    REQUIRE(histogram.snapshot().cumulative_counts.size() > detail::MetricCountLine::size);
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 8; ++i) {
+        threads.emplace_back([&histogram] {
+            for (auto j = 0; j < 10'000; ++j) {
+                histogram.observe(1e-7);
+                histogram.observe(100.0);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto const snapshot = histogram.snapshot();
+    CHECK(snapshot.cumulative_counts.front() == 80'000u);
+    CHECK(snapshot.cumulative_counts[snapshot.cumulative_counts.size() - 2u] == 80'000u);
+    CHECK(snapshot.count == 160'000u);
+    CHECK(snapshot.sum == doctest::Approx(8'000'000.008));
+}
+
+TEST_CASE("[ltb][util][metrics] prometheus text export") {
+    auto registry = MetricsRegistry{};
+    registry.counter("errors_total", "Errors reported", R"(severity="warning")").increment(3u);
+    registry.counter("errors_total", "Errors reported", R"(severity="error")").increment();
+    registry.gauge("queue_depth", "").add(7);
+    registry.histogram("task_seconds", "Task run time", {0.5, 1.0}, R"(queue="io")").observe(0.75);
+
+    CHECK(registry.to_prometheus_string()
+          == "# HELP errors_total Errors reported\n"
+             "# TYPE errors_total counter\n"
+             "errors_total{severity=\"error\"} 1\n"
+             "errors_total{severity=\"warning\"} 3\n"
+             "# TYPE queue_depth gauge\n"
+             "queue_depth 7\n"
+             "# HELP task_seconds Task run time\n"
+             "# TYPE task_seconds histogram\n"
+             "task_seconds_bucket{queue=\"io\",le=\"0.5\"} 0\n"
+             "task_seconds_bucket{queue=\"io\",le=\"1\"} 1\n"
+             "task_seconds_bucket{queue=\"io\",le=\"+Inf\"} 1\n"
+             "task_seconds_sum{queue=\"io\"} 0.75\n"
+             "task_seconds_count{queue=\"io\"} 1\n");
+
+    auto const filename = std::filesystem::temp_directory_path() / "ltb_util_metrics_test.prom";
+    CHECK(registry.write_prometheus(filename).has_value());
+    CHECK(std::filesystem::file_size(filename) > 0u);
+    std::filesystem::remove(filename);
+
+    CHECK_FALSE(registry.write_prometheus(std::filesystem::path("not") / "a" / "directory" / "metrics.prom"));
+}
+
+} // namespace ltb::util
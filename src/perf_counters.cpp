@@ -0,0 +1,276 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/perf_counters.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// standard
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+namespace ltb::util {
+namespace {
+
+#if defined(__linux__)
+
+constexpr auto counter_configs = std::array<std::uint64_t, 4>{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+/// \brief The layout returned by `read` for `PERF_FORMAT_GROUP` with both time fields.
+struct GroupReading {
+    std::uint64_t                                     counter_count = 0u;
+    std::uint64_t                                     time_enabled  = 0u;
+    std::uint64_t                                     time_running  = 0u;
+    std::array<std::uint64_t, counter_configs.size()> values        = {};
+};
+
+auto open_counter(std::uint64_t config, int group_fd) -> int {
+    auto attributes           = perf_event_attr{};
+    attributes.type           = PERF_TYPE_HARDWARE;
+    attributes.size           = sizeof(perf_event_attr);
+    attributes.config         = config;
+    attributes.disabled       = (group_fd == -1 ? 1u : 0u); // The whole group is enabled by its leader
+    attributes.exclude_kernel = 1u;
+    attributes.exclude_hv     = 1u;
+    attributes.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // pid = 0 and cpu = -1 counts the calling thread on any CPU.
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+#endif
+
+} // namespace
+
+auto HardwareCounts::ipc() const -> double {
+    return cycles == 0u ? 0.0 : static_cast<double>(instructions) / static_cast<double>(cycles);
+}
+
+auto operator-(HardwareCounts const& lhs, HardwareCounts const& rhs) -> HardwareCounts {
+    return {
+        lhs.cycles - rhs.cycles,
+        lhs.instructions - rhs.instructions,
+        lhs.cache_misses - rhs.cache_misses,
+        lhs.branch_misses - rhs.branch_misses,
+    };
+}
+
+auto counts_between(PerfCounterReading const& start, PerfCounterReading const& end) -> std::optional<HardwareCounts> {
+    if (end.time_running <= start.time_running || end.time_enabled < start.time_enabled) {
+        return std::nullopt;
+    }
+
+    // The raw counts never decrease so they are subtracted before scaling. Scaling each
+    // reading separately can make the end smaller than the start when the counters were
+    // multiplexed before the interval but not during it.
+    auto const scale  = static_cast<double>(end.time_enabled - start.time_enabled)
+                     / static_cast<double>(end.time_running - start.time_running);
+    auto const counts = end.raw - start.raw;
+    auto const scaled = [scale](std::uint64_t value) {
+        return static_cast<std::uint64_t>(static_cast<double>(value) * scale);
+    };
+    return HardwareCounts{
+        scaled(counts.cycles),
+        scaled(counts.instructions),
+        scaled(counts.cache_misses),
+        scaled(counts.branch_misses),
+    };
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+#if defined(__linux__)
+    for (auto i = 0u; i < fds_.size(); ++i) {
+        fds_[i] = open_counter(counter_configs[i], (i == 0u ? -1 : fds_[0]));
+
+        if (fds_[i] < 0) {
+            // All or nothing so every reading has the same meaning.
+            for (auto& fd : fds_) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                fd = -1;
+            }
+            return;
+        }
+    }
+    ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+#if defined(__linux__)
+    for (auto fd : fds_) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+auto PerfCounterGroup::available() const -> bool {
+    return fds_[0] >= 0;
+}
+
+auto PerfCounterGroup::read() const -> std::optional<PerfCounterReading> {
+#if defined(__linux__)
+    if (!available()) {
+        return std::nullopt;
+    }
+
+    auto reading = GroupReading{};
+    if (::read(fds_[0], &reading, sizeof(reading)) != static_cast<ssize_t>(sizeof(reading))
+        || reading.counter_count != counter_configs.size()) {
+        return std::nullopt;
+    }
+
+    return PerfCounterReading{
+        {reading.values[0], reading.values[1], reading.values[2], reading.values[3]},
+        reading.time_enabled,
+        reading.time_running,
+    };
+#else
+    return std::nullopt;
+#endif
+}
+
+auto this_thread_perf_counters() -> PerfCounterGroup& {
+    thread_local auto group = PerfCounterGroup{};
+    return group;
+}
+
+auto write_perf_counters(std::ostream& os, PerfCounters const& counters, std::uint64_t elements) -> void {
+    auto stream = std::ostringstream{};
+    stream << std::to_string(to_millis<double>(counters.wall)) << "ms";
+
+    if (counters.hardware) {
+        auto const& hardware    = *counters.hardware;
+        auto const  per_element = [elements](std::uint64_t count) {
+            return static_cast<double>(count) / static_cast<double>(std::max(elements, std::uint64_t{1u}));
+        };
+        stream << std::setprecision(3) << ", IPC " << hardware.ipc() << ", " << per_element(hardware.cycles)
+               << " cycles/element, " << per_element(hardware.cache_misses) << " cache misses/element, "
+               << per_element(hardware.branch_misses) << " branch misses/element";
+    } else {
+        stream << " (hardware counters unavailable)";
+    }
+    os << stream.str();
+}
+
+PerfTimer::PerfTimer() {
+    start();
+}
+
+auto PerfTimer::start() -> void {
+    start_reading_ = this_thread_perf_counters().read();
+    start_wall_    = std::chrono::steady_clock::now();
+}
+
+auto PerfTimer::elapsed() const -> PerfCounters {
+    auto const end_wall    = std::chrono::steady_clock::now();
+    auto const end_reading = this_thread_perf_counters().read();
+
+    auto counters = PerfCounters{};
+    counters.wall = end_wall - start_wall_;
+    if (start_reading_ && end_reading) {
+        counters.hardware = counts_between(*start_reading_, *end_reading);
+    }
+    return counters;
+}
+
+ScopedPerfZone::ScopedPerfZone(std::string name, std::uint64_t elements, std::ostream& os)
+    : name_(std::move(name)), elements_(elements), ostream_(os) {}
+
+ScopedPerfZone::~ScopedPerfZone() {
+    auto const counters = timer_.elapsed();
+    ostream_ << name_ << (name_.empty() ? "" : ": ");
+    write_perf_counters(ostream_, counters, elements_);
+    ostream_ << std::endl;
+}
+
+TEST_CASE("[ltb][util][perf_counters] derived values") {
+    auto const counts = HardwareCounts{1000u, 2500u, 10u, 4u};
+    CHECK(counts.ipc() == doctest::Approx(2.5));
+    CHECK(HardwareCounts{}.ipc() == 0.0);
+
+    auto const diff = counts - HardwareCounts{400u, 500u, 5u, 1u};
+    CHECK(diff.cycles == 600u);
+    CHECK(diff.instructions == 2000u);
+    CHECK(diff.cache_misses == 5u);
+    CHECK(diff.branch_misses == 3u);
+
+    auto stream = std::stringstream{};
+    write_perf_counters(stream, {duration_micros(1500), counts}, 100u);
+    CHECK(stream.str()
+          == "1.500000ms, IPC 2.5, 10 cycles/element, 0.1 cache misses/element, 0.04 branch misses/element");
+
+    stream = std::stringstream{};
+    write_perf_counters(stream, {duration_millis(2), std::nullopt}, 100u);
+    CHECK(stream.str() == "2.000000ms (hardware counters unavailable)");
+}
+
+TEST_CASE("[ltb][util][perf_counters] intervals are scaled by how long the counters ran during them") {
+    // Multiplexed before the interval (half the time) but counting for all of it.
+    auto const start = PerfCounterReading{{1000u, 2000u, 10u, 4u}, 2000u, 1000u};
+    auto const end   = PerfCounterReading{{1600u, 2800u, 16u, 5u}, 2600u, 1600u};
+
+    auto const counts = counts_between(start, end);
+    REQUIRE(counts.has_value());
+    CHECK(counts->cycles == 600u);
+    CHECK(counts->instructions == 800u);
+    CHECK(counts->cache_misses == 6u);
+    CHECK(counts->branch_misses == 1u);
+
+    // Counting for half of the interval
+    auto const half = counts_between(start, PerfCounterReading{{1300u, 2400u, 13u, 5u}, 2600u, 1300u});
+    REQUIRE(half.has_value());
+    CHECK(half->cycles == 600u);
+    CHECK(half->instructions == 800u);
+
+    // Not counting at all during the interval
+    CHECK_FALSE(counts_between(start, PerfCounterReading{{1000u, 2000u, 10u, 4u}, 2600u, 1000u}).has_value());
+}
+
+TEST_CASE("[ltb][util][perf_counters] zones fall back to time only when counters are unavailable") {
+    auto const available = this_thread_perf_counters().available();
+    CHECK(this_thread_perf_counters().read().has_value() == available);
+
+    auto values = std::vector<double>(100'000, 1.0);
+
+    auto timer = PerfTimer();
+    auto sum   = std::accumulate(values.begin(), values.end(), 0.0);
+    CHECK(sum == doctest::Approx(100'000.0));
+
+    auto const counters = timer.elapsed();
+    CHECK(counters.wall > Duration::zero());
+    CHECK(counters.hardware.has_value() == available);
+    if (counters.hardware) {
+        CHECK(counters.hardware->instructions > 0u);
+    }
+
+    auto stream = std::stringstream{};
+    {
+        auto zone = ScopedPerfZone("sum", values.size(), stream);
+        sum       = std::accumulate(values.begin(), values.end(), 0.0);
+    }
+    CHECK(stream.str().find("sum: ") == 0u);
+    CHECK((stream.str().find("cycles/element") != std::string::npos) == available);
+}
+
+} // namespace ltb::util
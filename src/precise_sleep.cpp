@@ -0,0 +1,118 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/precise_sleep.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <cmath>
+
+namespace ltb::util {
+namespace {
+
+using namespace std::chrono_literals;
+
+// A typical wake-up delay on an idle Linux machine, refined after the first few sleeps.
+constexpr auto initial_mean_oversleep_nanos      = 50'000.0;
+constexpr auto initial_oversleep_deviation_nanos = 25'000.0;
+
+// Smoothing factors for the mean and deviation (1/8 and 1/4, as in TCP's RTT estimator).
+constexpr auto mean_gain      = 0.125;
+constexpr auto deviation_gain = 0.25;
+
+} // namespace
+
+PreciseSleeper::PreciseSleeper(Duration max_spin)
+    : max_spin_(max_spin),
+      mean_oversleep_nanos_(initial_mean_oversleep_nanos),
+      oversleep_deviation_nanos_(initial_oversleep_deviation_nanos) {}
+
+auto PreciseSleeper::margin() const -> Duration {
+    auto const margin_nanos = mean_oversleep_nanos_ + 4.0 * oversleep_deviation_nanos_;
+    return std::clamp(duration_nanos(static_cast<std::int64_t>(margin_nanos)), Duration::zero(), max_spin_);
+}
+
+auto PreciseSleeper::record_oversleep(Duration oversleep) -> void {
+    auto const sample = std::max(0.0, to_nanos<double>(oversleep));
+    auto const error  = sample - mean_oversleep_nanos_;
+    mean_oversleep_nanos_ += mean_gain * error;
+    oversleep_deviation_nanos_ += deviation_gain * (std::abs(error) - oversleep_deviation_nanos_);
+}
+
+TEST_CASE("[ltb][util][precise_sleep] the margin follows recent wake-up delays") {
+    auto sleeper = PreciseSleeper(10ms);
+    CHECK(sleeper.margin() == 150us);
+
+    for (auto i = 0; i < 100; ++i) {
+        sleeper.record_oversleep(2ms);
+    }
+    CHECK(sleeper.margin() > 1900us);
+    CHECK(sleeper.margin() < 2100us);
+
+    for (auto i = 0; i < 100; ++i) {
+        sleeper.record_oversleep(20ms);
+    }
+    CHECK(sleeper.margin() == 10ms); // Clamped to `max_spin`
+
+    for (auto i = 0; i < 100; ++i) {
+        sleeper.record_oversleep(-1ms); // Early wake-ups count as on time
+    }
+    CHECK(sleeper.margin() < 10us);
+}
+
+TEST_CASE("[ltb][util][precise_sleep] never wakes before the deadline") {
+    for (auto i = 0; i < 20; ++i) {
+        auto const deadline = SteadyClock::now() + 1ms;
+        precise_sleep_until(deadline);
+        CHECK(SteadyClock::now() >= deadline);
+    }
+    CHECK(this_thread_sleeper().margin() <= 2ms);
+}
+
+TEST_CASE("[ltb][util][precise_sleep] the pacer skips ticks it has missed") {
+    auto pacer = BasicTickPacer<ManualClock>(10ms);
+    CHECK_THROWS_AS(BasicTickPacer<ManualClock>(0ms), std::invalid_argument);
+
+    ManualClock::advance(10ms);
+    auto tick = pacer.wait_for_next_tick(); // Due now
+    CHECK(tick.index == 0u);
+    CHECK(tick.missed == 0u);
+    CHECK(tick.lateness == 0ms);
+
+    ManualClock::advance(35ms);
+    tick = pacer.wait_for_next_tick(); // Due 5ms ago. The ticks due 25ms and 15ms ago are skipped.
+    CHECK(tick.index == 3u);
+    CHECK(tick.missed == 2u);
+    CHECK(tick.lateness == 5ms);
+    CHECK(pacer.missed_ticks() == 2u);
+
+    // The next tick stays on the grid
+    auto const deadline = pacer.next_deadline();
+    auto       advancer = std::thread([] {
+        std::this_thread::sleep_for(1ms);
+        ManualClock::advance(5ms);
+    });
+    tick = pacer.wait_for_next_tick();
+    advancer.join();
+    CHECK(ManualClock::now() == deadline);
+    CHECK(tick.index == 4u);
+    CHECK(tick.missed == 0u);
+    CHECK(tick.lateness == 0ms);
+}
+
+TEST_CASE("[ltb][util][precise_sleep] the pacer keeps a steady rate") {
+    auto pacer = TickPacer(2ms);
+    auto start = SteadyClock::now();
+    auto ticks = 0u;
+    while (ticks < 10u) {
+        auto const tick = pacer.wait_for_next_tick();
+        ticks += 1u + static_cast<unsigned>(tick.missed);
+        CHECK(tick.lateness >= 0ms);
+    }
+    CHECK(SteadyClock::now() - start >= 20ms);
+}
+
+} // namespace ltb::util
@@ -0,0 +1,194 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/rate_limiter.hpp"
+
+// project
+#include "ltb/util/async_task_runner.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace ltb;
+using namespace std::chrono_literals;
+
+using Clock = util::ManualClock;
+
+TEST_CASE("[ltb][util][rate_limiter] token bucket refills at a fixed rate") {
+    // 10 tokens per second, up to 5 at once
+    auto bucket = util::BasicTokenBucket<Clock>(10u, 1s, 5u);
+    CHECK_THROWS_AS(util::BasicTokenBucket<Clock>(0u, 1s, 5u), std::invalid_argument);
+    CHECK_THROWS_AS(util::BasicTokenBucket<Clock>(10u, 1s, 0u), std::invalid_argument);
+
+    // Starts full
+    CHECK(bucket.try_acquire(3u));
+    CHECK(bucket.try_acquire(2u));
+    CHECK_FALSE(bucket.try_acquire());
+    CHECK(bucket.time_until_available() == 100ms);
+    CHECK(bucket.time_until_available(3u) == 300ms);
+
+    Clock::advance(250ms);
+    CHECK(bucket.try_acquire(2u));
+    CHECK_FALSE(bucket.try_acquire());
+    CHECK(bucket.time_until_available() == 50ms);
+
+    // Never holds more than `burst` tokens
+    Clock::advance(1h);
+    CHECK(bucket.try_acquire(5u));
+    CHECK_FALSE(bucket.try_acquire());
+    CHECK_FALSE(bucket.try_acquire(6u));
+}
+
+TEST_CASE("[ltb][util][rate_limiter] token bucket acquire reserves future tokens") {
+    auto bucket = util::BasicTokenBucket<Clock>(10u, 1s, 1u);
+    CHECK(bucket.try_acquire());
+
+    // Refuses immediately, without taking anything, if the wait is longer than the timeout
+    CHECK_FALSE(bucket.acquire(1u, 50ms));
+    CHECK(bucket.time_until_available() == 100ms);
+
+    auto const start    = Clock::now();
+    auto       acquired = false;
+    auto       waiter   = std::thread([&bucket, &acquired] { acquired = bucket.acquire(3u, 1s); });
+
+    // The waiter holds a reservation so nothing else is available until it is served
+    while (bucket.time_until_available() == 100ms) {
+        std::this_thread::yield();
+    }
+    CHECK(bucket.time_until_available() == 400ms);
+    CHECK_FALSE(bucket.try_acquire());
+
+    Clock::advance(300ms);
+    waiter.join();
+    CHECK(acquired);
+    CHECK(Clock::now() - start == 300ms);
+}
+
+TEST_CASE("[ltb][util][rate_limiter] token bucket is shared safely between threads") {
+    auto bucket = util::TokenBucket(1000u, 1h, 1000u);
+
+    auto acquired = std::atomic_int{0};
+    auto threads  = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&bucket, &acquired] {
+            for (auto j = 0; j < 500; ++j) {
+                if (bucket.try_acquire()) {
+                    ++acquired;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(acquired == 1000); // Less than one token is added in the few milliseconds the test takes
+}
+
+TEST_CASE("[ltb][util][rate_limiter] sliding window weights the previous window") {
+    auto limiter = util::BasicSlidingWindowLimiter<Clock>(10u, 1s);
+    CHECK_THROWS_AS(util::BasicSlidingWindowLimiter<Clock>(0u, 1s), std::invalid_argument);
+
+    // Line the test up with the start of a window
+    Clock::advance(1s - (Clock::now().time_since_epoch() % 1s));
+
+    CHECK(limiter.try_acquire(8u));
+    CHECK(limiter.try_acquire(2u));
+    CHECK_FALSE(limiter.try_acquire());
+    CHECK_FALSE(limiter.try_acquire(11u));
+    CHECK(limiter.time_until_available(11u) == util::Duration::max());
+
+    // A quarter into the next window, 3/4 of the previous window's 10 still count
+    Clock::advance(1250ms);
+    CHECK(limiter.try_acquire(2u));
+    CHECK_FALSE(limiter.try_acquire(2u));
+
+    // 3 fit once the weight drops to 7/10 and 4 fit once it drops to 6/10
+    CHECK(util::to_millis<double>(limiter.time_until_available()) == doctest::Approx(50.0).epsilon(0.01));
+    CHECK(util::to_millis<double>(limiter.time_until_available(2u)) == doctest::Approx(150.0).epsilon(0.01));
+
+    Clock::advance(150ms);
+    CHECK(limiter.try_acquire(2u));
+    CHECK_FALSE(limiter.try_acquire());
+}
+
+TEST_CASE("[ltb][util][rate_limiter] sliding window acquire waits for the window to slide") {
+    auto limiter = util::BasicSlidingWindowLimiter<Clock>(2u, 100ms);
+    CHECK(limiter.try_acquire(2u));
+    CHECK_FALSE(limiter.acquire(1u, 0ms));
+
+    auto acquired = std::atomic_bool{false};
+    auto waiter   = std::thread([&limiter, &acquired] { acquired = limiter.acquire(2u, 1s); });
+    while (!acquired) {
+        Clock::advance(10ms);
+        std::this_thread::sleep_for(1ms);
+    }
+    waiter.join();
+    CHECK(acquired);
+    CHECK_FALSE(limiter.try_acquire());
+}
+
+TEST_CASE("[ltb][util][rate_limiter] AsyncTaskRunner defers tasks over the limit") {
+    // Three tasks at once, then one every 10ms
+    auto bucket = util::TokenBucket(1u, 10ms, 3u);
+
+    auto task_runner = util::AsyncTaskRunner<util::SteadyClock::time_point>(nullptr, util::rate_limit(bucket));
+
+    auto const start = util::SteadyClock::now();
+    auto       times = std::vector<util::SteadyClock::time_point>{};
+    for (auto i = 0; i < 6; ++i) {
+        task_runner.schedule_task([] { return util::SteadyClock::now(); },
+                                  [&times](auto&& time) { times.emplace_back(time); });
+    }
+    for (auto i = 0; i < 6; ++i) {
+        task_runner.invoke_next_callback_blocking();
+    }
+
+    REQUIRE(times.size() == 6u);
+    CHECK(times[2] - start < 10ms);
+    CHECK(times[5] - start >= 30ms);
+}
+
+TEST_CASE("[ltb][util][rate_limiter] AsyncTaskRunner polls limiters on a manual clock") {
+    // One task an hour, as measured by the manual clock
+    auto bucket = util::BasicTokenBucket<Clock>(1u, 1h, 1u);
+
+    auto const start       = util::SteadyClock::now();
+    auto       task_runner = util::AsyncTaskRunner<bool>(nullptr, util::rate_limit(bucket));
+    for (auto i = 0; i < 2; ++i) {
+        task_runner.schedule_task([] { return true; });
+    }
+    task_runner.invoke_next_callback_blocking();
+
+    // The second task runs soon after the clock reaches the next token, not an hour of real time later
+    Clock::advance(1h);
+    task_runner.invoke_next_callback_blocking();
+    CHECK(util::SteadyClock::now() - start < 1s);
+}
+
+TEST_CASE("[ltb][util][rate_limiter] AsyncTaskRunner stops while tasks are deferred") {
+    auto bucket = util::TokenBucket(1u, 1h, 1u);
+    auto ran    = std::atomic_int{0};
+
+    auto const start = util::SteadyClock::now();
+    {
+        auto task_runner = util::AsyncTaskRunner<bool>(nullptr, util::rate_limit(bucket));
+        for (auto i = 0; i < 3; ++i) {
+            task_runner.schedule_task([&ran] {
+                ++ran;
+                return true;
+            });
+        }
+        task_runner.invoke_next_callback_blocking();
+    }
+    CHECK(ran == 1);
+    CHECK(util::SteadyClock::now() - start < 1s);
+}
+
+} // namespace
@@ -0,0 +1,82 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/ring_buffer.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace ltb;
+
+TEST_CASE("[ltb][util][ring_buffer] values are popped in order until empty") {
+    auto buffer = util::MpscRingBuffer<std::string>(3u);
+    CHECK(buffer.capacity() == 4u);
+    CHECK_FALSE(buffer.try_pop().has_value());
+
+    CHECK(buffer.try_push("a"));
+    CHECK(buffer.try_push(std::string("b")));
+    CHECK(buffer.try_push("c"));
+    CHECK(buffer.try_push("d"));
+    CHECK_FALSE(buffer.try_push("full"));
+
+    CHECK(buffer.try_pop() == "a");
+    CHECK(buffer.try_push("e"));
+
+    // Wraps around the end of the buffer
+    for (auto const* expected : {"b", "c", "d", "e"}) {
+        CHECK(buffer.try_pop() == expected);
+    }
+    CHECK_FALSE(buffer.try_pop().has_value());
+}
+
+TEST_CASE("[ltb][util][ring_buffer] many producers and one consumer") {
+    constexpr auto producer_count = 4;
+    constexpr auto values_per     = 20'000;
+
+    struct Value {
+        int producer = 0;
+        int index    = 0;
+    };
+
+    auto buffer    = util::MpscRingBuffer<Value>(64u);
+    auto producers = std::vector<std::thread>{};
+
+    for (auto p = 0; p < producer_count; ++p) {
+        producers.emplace_back([&buffer, p] {
+            for (auto i = 0; i < values_per; ++i) {
+                while (!buffer.try_push(Value{p, i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Values from each producer arrive in the order they were pushed
+    auto next_index = std::vector<int>(producer_count, 0);
+    auto in_order   = true;
+    for (auto received = 0; received < producer_count * values_per;) {
+        if (auto value = buffer.try_pop()) {
+            in_order = in_order && (value->index == next_index[value->producer]);
+            ++next_index[value->producer];
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    CHECK(in_order);
+    CHECK(next_index == std::vector<int>(producer_count, values_per));
+    CHECK_FALSE(buffer.try_pop().has_value());
+}
+
+} // namespace
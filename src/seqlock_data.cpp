@@ -0,0 +1,110 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/seqlock_data.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Pose {
+    double x     = 0.0;
+    double y     = 0.0;
+    double z     = 0.0;
+    double check = 0.0; ///< Always x + y + z unless a write was torn
+};
+
+static_assert(ltb::util::prefer_seqlock_v<int>);
+static_assert(ltb::util::prefer_seqlock_v<Pose>);
+static_assert(!ltb::util::prefer_seqlock_v<std::string>);
+static_assert(!ltb::util::prefer_seqlock_v<std::array<char, 256>>);
+
+static_assert(std::is_same_v<ltb::util::AtomicValue<Pose>, ltb::util::SeqLockData<Pose>>);
+static_assert(std::is_same_v<ltb::util::AtomicValue<std::string>, ltb::util::AtomicData<std::string>>);
+
+TEST_CASE("[ltb][util][seqlock] load and store") {
+    auto shared_pose = ltb::util::SeqLockData<Pose>{};
+
+    auto pose = shared_pose.load();
+    CHECK(pose.x == 0.0);
+    CHECK(pose.check == 0.0);
+
+    shared_pose.store({1.0, 2.0, 3.0, 6.0});
+
+    pose = shared_pose.load();
+    CHECK(pose.x == 1.0);
+    CHECK(pose.y == 2.0);
+    CHECK(pose.z == 3.0);
+    CHECK(pose.check == 6.0);
+}
+
+TEST_CASE("[ltb][util][seqlock] use_safely") {
+    // Odd sizes should round trip through the word buffer.
+    auto shared_bytes = ltb::util::SeqLockData<std::array<char, 13>>{};
+
+    auto previous_front = shared_bytes.use_safely([](auto& bytes) {
+        auto front = bytes.front();
+        bytes.fill('z');
+        return front;
+    });
+    CHECK(previous_front == '\0');
+    CHECK(shared_bytes.load().back() == 'z');
+
+    shared_bytes.use_safely([](auto& bytes) { bytes.back() = 'a'; });
+    CHECK(shared_bytes.load().front() == 'z');
+    CHECK(shared_bytes.load().back() == 'a');
+}
+
+TEST_CASE("[ltb][util][seqlock] readers never see torn writes") {
+    auto shared_pose = ltb::util::SeqLockData<Pose>{};
+
+    constexpr auto writes_per_thread = 10'000;
+
+    auto writers = std::array<std::thread, 2>{};
+    for (auto w = 0u; w < writers.size(); ++w) {
+        writers[w] = std::thread([&shared_pose, w] {
+            for (auto i = 0; i < writes_per_thread; ++i) {
+                if (w == 0u) {
+                    auto value = static_cast<double>(i);
+                    shared_pose.store({value, value * 2.0, value * 3.0, value * 6.0});
+                } else {
+                    shared_pose.use_safely([](Pose& pose) {
+                        pose.x += 1.0;
+                        pose.check += 1.0;
+                    });
+                }
+            }
+        });
+    }
+
+    auto torn_reads = std::vector<int>(4, 0);
+    auto readers    = std::array<std::thread, 4>{};
+    for (auto r = 0u; r < readers.size(); ++r) {
+        readers[r] = std::thread([&shared_pose, &torn_reads, r] {
+            for (auto i = 0; i < writes_per_thread; ++i) {
+                auto pose = shared_pose.load();
+                if (pose.x + pose.y + pose.z != pose.check) {
+                    ++torn_reads[r];
+                }
+            }
+        });
+    }
+
+    for (auto& thread : writers) {
+        thread.join();
+    }
+    for (auto& thread : readers) {
+        thread.join();
+    }
+
+    CHECK(torn_reads == std::vector<int>(4, 0));
+}
+
+} // namespace
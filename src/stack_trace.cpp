@@ -0,0 +1,241 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/stack_trace.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// Frame pointers are only walked when everything linking the library is built with them.
+// Otherwise the saved frame pointer slot of a caller built without them holds an arbitrary
+// register value, and the walk could return bogus frames before it stops.
+#if defined(LTB_ERROR_STACK_TRACES) && defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define LTB_WALK_FRAME_POINTERS
+#include <pthread.h>
+#elif __has_include(<execinfo.h>)
+#include <execinfo.h>
+#endif
+
+#if __has_include(<dlfcn.h>) && __has_include(<cxxabi.h>)
+#define LTB_HAS_DLADDR
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+
+// standard
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace ltb::util {
+namespace {
+
+#if defined(LTB_ERROR_STACK_TRACES)
+auto error_stack_traces = std::atomic_bool{true};
+#else
+auto error_stack_traces = std::atomic_bool{false};
+#endif
+
+struct SymbolCache {
+    std::mutex                              mutex;
+    std::unordered_map<void*, std::string> names;
+};
+
+auto symbol_cache() -> SymbolCache& {
+    // Leaked so errors can be printed during static destruction.
+    static auto* cache = new SymbolCache();
+    return *cache;
+}
+
+#if defined(LTB_WALK_FRAME_POINTERS)
+/// \brief The highest address of the calling thread's stack, or zero if it is unknown.
+auto this_thread_stack_top() -> std::uintptr_t {
+    thread_local auto const top = [] {
+        auto result     = std::uintptr_t{0u};
+        auto attributes = pthread_attr_t{};
+        if (::pthread_getattr_np(::pthread_self(), &attributes) == 0) {
+            auto* bottom = static_cast<void*>(nullptr);
+            auto  size   = std::size_t{0u};
+            if (::pthread_attr_getstack(&attributes, &bottom, &size) == 0) {
+                result = reinterpret_cast<std::uintptr_t>(bottom) + size;
+            }
+            ::pthread_attr_destroy(&attributes);
+        }
+        return result;
+    }();
+    return top;
+}
+#endif
+
+auto describe(void* address) -> std::string {
+    auto stream = std::ostringstream{};
+    stream << std::hex << std::showbase;
+
+#if defined(LTB_HAS_DLADDR)
+    auto info = Dl_info{};
+    if (::dladdr(address, &info) != 0) {
+        auto const offset_from = [address](void const* base) {
+            return reinterpret_cast<std::uintptr_t>(address) - reinterpret_cast<std::uintptr_t>(base);
+        };
+
+        if (info.dli_sname != nullptr) {
+            auto  status    = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            stream << (status == 0 ? demangled : info.dli_sname) << '+' << offset_from(info.dli_saddr);
+            std::free(demangled);
+        }
+        if (info.dli_fname != nullptr) {
+            stream << (info.dli_sname != nullptr ? " " : "") << '(' << info.dli_fname << '+'
+                   << offset_from(info.dli_fbase) << ')';
+        }
+        return stream.str();
+    }
+#endif
+
+    stream << "??";
+    return stream.str();
+}
+
+} // namespace
+
+[[gnu::noinline]] auto StackTrace::capture(std::size_t skip) -> StackTrace {
+    auto trace = StackTrace{};
+
+#if defined(LTB_WALK_FRAME_POINTERS)
+    // Each frame starts with the caller's frame pointer followed by the return address. The walk stops
+    // at the first frame pointer that doesn't move up the stack (the outermost frame, for example).
+    // Every frame read is between this function's frame and the top of the stack, so it is mapped.
+    auto const  top   = this_thread_stack_top();
+    auto const* frame = static_cast<void* const*>(__builtin_frame_address(0));
+
+    while (trace.size_ < max_frames) {
+        auto const address = reinterpret_cast<std::uintptr_t>(frame);
+        if (address + 2u * sizeof(void*) > top || address % alignof(void*) != 0u || frame[1] == nullptr) {
+            break;
+        }
+        if (skip > 0u) {
+            --skip;
+        } else {
+            trace.frames_[trace.size_++] = frame[1];
+        }
+
+        auto const* next = static_cast<void* const*>(frame[0]);
+        if (next <= frame) {
+            break;
+        }
+        frame = next;
+    }
+
+#elif __has_include(<execinfo.h>)
+    // The first frame is this function.
+    auto       frames = std::array<void*, 2u * max_frames>{};
+    auto const count  = static_cast<std::size_t>(::backtrace(frames.data(), static_cast<int>(frames.size())));
+    auto const first  = std::min(count, skip + 1u);
+    trace.size_       = std::min(count - first, max_frames);
+    std::copy_n(frames.begin() + static_cast<std::ptrdiff_t>(first), trace.size_, trace.frames_.begin());
+
+#else
+    static_cast<void>(skip);
+#endif
+
+    return trace;
+}
+
+auto StackTrace::size() const -> std::size_t {
+    return size_;
+}
+
+auto StackTrace::empty() const -> bool {
+    return size_ == 0u;
+}
+
+auto StackTrace::begin() const -> void* const* {
+    return frames_.data();
+}
+
+auto StackTrace::end() const -> void* const* {
+    return frames_.data() + size_;
+}
+
+auto StackTrace::to_string() const -> std::string {
+    auto stream = std::ostringstream{};
+    for (auto i = 0u; i < size_; ++i) {
+        stream << '#' << i << ' ' << frames_[i] << ' ' << symbolize(frames_[i]) << '\n';
+    }
+    return stream.str();
+}
+
+auto symbolize(void* address) -> std::string {
+    auto& cache = symbol_cache();
+    auto  lock  = std::lock_guard(cache.mutex);
+
+    auto iter = cache.names.find(address);
+    if (iter == cache.names.end()) {
+        iter = cache.names.emplace(address, describe(address)).first;
+    }
+    return iter->second;
+}
+
+auto set_error_stack_traces_enabled(bool enabled) -> bool {
+    return error_stack_traces.exchange(enabled, std::memory_order_relaxed);
+}
+
+auto error_stack_traces_enabled() -> bool {
+    return error_stack_traces.load(std::memory_order_relaxed);
+}
+
+namespace {
+
+auto captured_frames = std::size_t{0u};
+
+// Kept out of line, and using the trace after capturing it, so these get their own frames.
+[[gnu::noinline]] auto capture_here(std::size_t skip) -> StackTrace {
+    auto trace = StackTrace::capture(skip);
+    captured_frames += trace.size();
+    return trace;
+}
+
+[[gnu::noinline]] auto capture_from_caller() -> StackTrace {
+    auto trace = capture_here(1u);
+    captured_frames += trace.size();
+    return trace;
+}
+
+/// \brief True if `address` is a return address inside `function`.
+template <typename Function>
+auto is_inside(void* address, Function* function) -> bool {
+    auto const start = reinterpret_cast<std::uintptr_t>(function);
+    auto const value = reinterpret_cast<std::uintptr_t>(address);
+    return value > start && value < start + 256u;
+}
+
+TEST_CASE("[ltb][util][stack_trace] capture starts at the caller") {
+    auto const trace = capture_here(0u);
+    REQUIRE_FALSE(trace.empty());
+    CHECK(trace.size() <= StackTrace::max_frames);
+    CHECK(is_inside(*trace.begin(), &capture_here));
+
+    auto const skipped = capture_from_caller();
+    REQUIRE_FALSE(skipped.empty());
+    CHECK(is_inside(*skipped.begin(), &capture_from_caller));
+}
+
+TEST_CASE("[ltb][util][stack_trace] symbols are looked up once per address") {
+    auto const trace = capture_here(0u);
+    REQUIRE_FALSE(trace.empty());
+    CHECK_FALSE(symbolize(*trace.begin()).empty());
+    CHECK(symbolize(*trace.begin()) == symbolize(*trace.begin()));
+
+    auto const text  = trace.to_string();
+    auto const lines = static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+    CHECK(lines == trace.size());
+    CHECK(text.rfind("#0 ", 0) == 0u);
+}
+
+} // namespace
+
+} // namespace ltb::util
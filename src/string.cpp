@@ -9,6 +9,7 @@
 // standard
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
 
 namespace ltb::util {
 
@@ -37,4 +38,30 @@ auto to_lower_ascii(std::string const& str) -> std::string {
     return result;
 }
 
+auto to_json_string(std::string const& str) -> std::string {
+    auto result = std::string("\"");
+    result.reserve(str.size() + 2u);
+
+    for (auto c : str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20u) {
+            char escaped[7];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            result += escaped;
+        } else {
+            result += c;
+        }
+    }
+    return result + '"';
+}
+
+TEST_CASE("[ltb][util][string] to_json_string") {
+    CHECK(to_json_string("") == R"("")");
+    CHECK(to_json_string("plain text") == R"("plain text")");
+    CHECK(to_json_string(R"(a "quoted" \path)") == R"("a \"quoted\" \\path")");
+    CHECK(to_json_string("tab\tnewline\n") == R"("tab\u0009newline\u000a")");
+}
+
 } // namespace ltb::util
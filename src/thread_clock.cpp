@@ -0,0 +1,82 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/thread_clock.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <ctime>
+#endif
+
+// standard
+#include <thread>
+
+namespace ltb::util {
+
+auto ThreadCpuClock::now() noexcept -> time_point {
+#if defined(_WIN32)
+    auto creation_time = FILETIME{};
+    auto exit_time     = FILETIME{};
+    auto kernel_time   = FILETIME{};
+    auto user_time     = FILETIME{};
+    ::GetThreadTimes(::GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time);
+
+    auto to_100_nanos = [](FILETIME const& time) {
+        return (std::uint64_t{time.dwHighDateTime} << 32u) | std::uint64_t{time.dwLowDateTime};
+    };
+    return time_point(duration_nanos((to_100_nanos(kernel_time) + to_100_nanos(user_time)) * 100u));
+#else
+    auto time = timespec{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time_point(duration_seconds(time.tv_sec) + duration_nanos(time.tv_nsec));
+#endif
+}
+
+auto thread_context_switches() -> std::optional<ContextSwitches> {
+#if defined(RUSAGE_THREAD)
+    auto usage = rusage{};
+    if (::getrusage(RUSAGE_THREAD, &usage) != 0) {
+        return std::nullopt;
+    }
+    return ContextSwitches{usage.ru_nvcsw, usage.ru_nivcsw};
+#else
+    return std::nullopt;
+#endif
+}
+
+TEST_CASE("[ltb][util][thread_clock] cpu time only advances while running") {
+    using namespace std::chrono_literals;
+
+    auto const start = ThreadCpuClock::now();
+    std::this_thread::sleep_for(20ms);
+    auto const after_sleep = ThreadCpuClock::now();
+    CHECK(after_sleep - start < 10ms);
+
+    auto sum = 0.0;
+    for (auto i = 0; i < 10'000'000; ++i) {
+        sum += static_cast<double>(i);
+    }
+    CHECK(sum > 0.0);
+    CHECK(ThreadCpuClock::now() > after_sleep);
+}
+
+TEST_CASE("[ltb][util][thread_clock] sleeping is a voluntary context switch") {
+    using namespace std::chrono_literals;
+
+    auto const before = thread_context_switches();
+    std::this_thread::sleep_for(1ms);
+    auto const after = thread_context_switches();
+
+    CHECK(before.has_value() == after.has_value());
+    if (before && after) {
+        CHECK(after->voluntary > before->voluntary);
+        CHECK(after->involuntary >= before->involuntary);
+    }
+}
+
+} // namespace ltb::util
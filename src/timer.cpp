@@ -3,38 +3,164 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #include "ltb/util/timer.hpp"
 
+// project
+#include "ltb/util/blocking_queue.hpp"
+#include "ltb/util/clock.hpp"
+#include "ltb/util/tsc_clock.hpp"
+
+// external
+#include <doctest/doctest.h>
+
 // standard
-#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <thread>
 
 namespace ltb::util {
 
-Timer::Timer(std::string name, std::ostream* os)
-    : name_(std::move(name)), ostream_(os), start_time_(std::chrono::steady_clock::now()) {}
+auto ThreadTimes::off_cpu() const -> Duration {
+    return std::max(wall - cpu, Duration::zero());
+}
+
+auto operator<<(std::ostream& os, ThreadTimes const& times) -> std::ostream& {
+    os << "wall " << std::to_string(to_millis<double>(times.wall)) << "ms, cpu "
+       << std::to_string(to_millis<double>(times.cpu)) << "ms";
+    if (times.switches) {
+        os << ", context switches " << times.switches->voluntary << " voluntary " << times.switches->involuntary
+           << " involuntary";
+    }
+    return os;
+}
+
+ThreadTimer::ThreadTimer(bool count_context_switches) : count_context_switches_(count_context_switches) {
+    start();
+}
+
+auto ThreadTimer::start() -> void {
+    if (count_context_switches_) {
+        start_switches_ = thread_context_switches();
+    }
+    start_cpu_  = ThreadCpuClock::now();
+    start_wall_ = std::chrono::steady_clock::now();
+}
+
+auto ThreadTimer::elapsed() const -> ThreadTimes {
+    auto times = ThreadTimes{};
+    times.wall = std::chrono::steady_clock::now() - start_wall_;
+    times.cpu  = ThreadCpuClock::now() - start_cpu_;
+
+    if (start_switches_) {
+        if (auto const switches = thread_context_switches()) {
+            times.switches = ContextSwitches{switches->voluntary - start_switches_->voluntary,
+                                             switches->involuntary - start_switches_->involuntary};
+        }
+    }
+    return times;
+}
+
+ScopedThreadTimer::ScopedThreadTimer(std::string name, std::ostream& os, bool count_context_switches)
+    : name_(std::move(name)), ostream_(os), timer_(count_context_switches) {}
+
+ScopedThreadTimer::~ScopedThreadTimer() {
+    auto const times = timer_.elapsed();
+    ostream_ << name_ << (name_.empty() ? "" : ": ") << times << std::endl;
+}
+
+TEST_CASE_TEMPLATE("[ltb][util][timer] scoped timer prints elapsed time", Clock, std::chrono::steady_clock, TscClock) {
+    using namespace std::chrono_literals;
 
-auto Timer::start() -> void {
-    if (ostream_) {
-        (*ostream_) << name_ << "..." << std::endl;
+    auto stream = std::stringstream{};
+    {
+        auto scoped_timer = BasicScopedTimer<Clock>("sleeping", stream);
+        std::this_thread::sleep_for(2ms);
     }
-    start_time_ = std::chrono::steady_clock::now();
+    CHECK(stream.str().find("sleeping...\nsleeping: ") == 0u);
+    CHECK(stream.str().find("ms\n") != std::string::npos);
+
+    auto timer = BasicTimer<Clock>();
+    timer.start();
+    std::this_thread::sleep_for(2ms);
+    CHECK(timer.millis_since_start() >= 2.0);
+    CHECK(timer.elapsed() >= 2ms);
 }
 
-auto Timer::millis_since_start() -> double {
-    auto end_time = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration<double, std::milli>(end_time - start_time_).count();
+TEST_CASE_TEMPLATE("[ltb][util][timer] scoped timer records into a histogram",
+                   Clock,
+                   std::chrono::steady_clock,
+                   TscClock) {
+    using namespace std::chrono_literals;
 
-    if (ostream_) {
-        (*ostream_) << name_ << (name_.empty() ? "" : ": ") << std::to_string(duration) << "ms" << std::endl;
+    auto histogram = LatencyHistogram{};
+    for (auto i = 0; i < 3; ++i) {
+        auto scoped_timer = BasicScopedTimer<Clock>(histogram);
+        std::this_thread::sleep_for(1ms);
     }
+    CHECK(histogram.count() == 3u);
+    CHECK(histogram.summary().min >= 1ms);
+}
+
+TEST_CASE("[ltb][util][timer] timers can be driven by a manual clock") {
+    using namespace std::chrono_literals;
 
-    return duration;
+    auto timer = BasicTimer<ManualClock>();
+    CHECK(timer.elapsed() == 0ms);
+    ManualClock::advance(250ms);
+    CHECK(timer.elapsed() == 250ms);
+    CHECK(timer.millis_since_start() == 250.0);
+
+    auto histogram = LatencyHistogram{};
+    for (auto i = 1; i <= 3; ++i) {
+        auto scoped_timer = BasicScopedTimer<ManualClock>(histogram);
+        ManualClock::advance(duration_millis(i));
+    }
+    CHECK(histogram.count() == 3u);
+    CHECK(histogram.summary().min == 1ms);
 }
 
-ScopedTimer::ScopedTimer(std::string name, std::ostream& os) : timer_(std::move(name), &os) {
-    timer_.start();
+TEST_CASE("[ltb][util][timer] thread timer separates cpu time from blocked time") {
+    using namespace std::chrono_literals;
+
+    auto timer = ThreadTimer(true);
+    std::this_thread::sleep_for(20ms);
+    auto const sleeping = timer.elapsed();
+
+    CHECK(sleeping.wall >= 20ms);
+    CHECK(sleeping.cpu < sleeping.wall);
+    CHECK(sleeping.off_cpu() >= 10ms);
+    CHECK(sleeping.switches.has_value() == thread_context_switches().has_value());
+
+    timer.start();
+    auto sum = 0.0;
+    for (auto i = 0; i < 10'000'000; ++i) {
+        sum += static_cast<double>(i);
+    }
+    CHECK(sum > 0.0);
+    CHECK(timer.elapsed().cpu > 0ms);
+
+    CHECK_FALSE(ThreadTimer().elapsed().switches.has_value());
 }
 
-ScopedTimer::~ScopedTimer() {
-    timer_.millis_since_start();
+TEST_CASE("[ltb][util][timer] thread timer shows time blocked in pop_front") {
+    using namespace std::chrono_literals;
+
+    auto queue    = BlockingQueue<int>{};
+    auto producer = std::thread([&queue] {
+        std::this_thread::sleep_for(20ms);
+        queue.push_back(1);
+    });
+
+    auto stream = std::stringstream{};
+    {
+        auto scoped_timer = ScopedThreadTimer("pop_front", stream, true);
+        CHECK(queue.pop_front() == 1);
+    }
+    producer.join();
+
+    CHECK(stream.str().find("pop_front: wall ") == 0u);
+    CHECK(stream.str().find("ms, cpu ") != std::string::npos);
+    if (thread_context_switches()) {
+        CHECK(stream.str().find(" voluntary ") != std::string::npos);
+    }
 }
 
 } // namespace ltb::util
@@ -0,0 +1,180 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/timer_sink.hpp"
+
+// project
+#include "ltb/util/timer.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace ltb::util {
+namespace {
+
+struct TimerNameRegistry {
+    std::mutex                                     mutex;
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<std::string>                       names;
+};
+
+auto registry() -> TimerNameRegistry& {
+    // Leaked on purpose so ids can be used during static destruction.
+    static auto* registry = new TimerNameRegistry();
+    return *registry;
+}
+
+} // namespace
+
+auto timer_name_id(std::string const& name) -> std::uint32_t {
+    auto&      timer_names = registry();
+    auto const lock        = std::lock_guard(timer_names.mutex);
+
+    auto [iter, inserted] = timer_names.ids.try_emplace(name, static_cast<std::uint32_t>(timer_names.names.size()));
+    if (inserted) {
+        timer_names.names.push_back(name);
+    }
+    return iter->second;
+}
+
+auto timer_name(std::uint32_t id) -> std::string {
+    auto&      timer_names = registry();
+    auto const lock        = std::lock_guard(timer_names.mutex);
+
+    return id < timer_names.names.size() ? timer_names.names[id] : std::string{};
+}
+
+AsyncTimerSink::AsyncTimerSink(std::ostream& os, std::size_t capacity, Duration write_interval)
+    : os_(os), write_interval_(write_interval), reports_(capacity), writer_thread_([this] { write_loop(); }) {}
+
+AsyncTimerSink::~AsyncTimerSink() {
+    {
+        auto const lock = std::lock_guard(mutex_);
+        stopping_       = true;
+    }
+    wake_writer_.notify_one();
+    writer_thread_.join();
+}
+
+auto AsyncTimerSink::submit(TimerReport const& report) -> void {
+    if (!reports_.try_push(report)) {
+        dropped_.fetch_add(1u, std::memory_order_relaxed);
+    }
+}
+
+auto AsyncTimerSink::flush() -> void {
+    auto       lock   = std::unique_lock(mutex_);
+    auto const target = ++flushes_requested_;
+    wake_writer_.notify_one();
+    flushed_.wait(lock, [this, target] { return flushes_completed_ >= target; });
+}
+
+auto AsyncTimerSink::dropped() const -> std::uint64_t {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+auto AsyncTimerSink::write_loop() -> void {
+    // Names never change once registered so they are cached to avoid locking for every report.
+    auto names = std::vector<std::string>{};
+    auto batch = std::string{};
+
+    auto lock = std::unique_lock(mutex_);
+    while (true) {
+        wake_writer_.wait_for(lock, write_interval_, [this] {
+            return stopping_ || flushes_requested_ != flushes_completed_;
+        });
+        auto const stopping     = stopping_;
+        auto const flush_target = flushes_requested_;
+        lock.unlock();
+
+        batch.clear();
+        while (auto report = reports_.try_pop()) {
+            if (report->name_id >= names.size()) {
+                names.resize(report->name_id + 1u);
+            }
+            auto& name = names[report->name_id];
+            if (name.empty()) {
+                name = timer_name(report->name_id);
+            }
+            batch += name;
+            batch += (name.empty() ? "" : ": ");
+            batch += std::to_string(to_millis<double>(report->elapsed));
+            batch += "ms\n";
+        }
+
+        if (!batch.empty()) {
+            os_.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        }
+        if (stopping || flush_target != flushes_completed_) {
+            os_.flush();
+        }
+
+        lock.lock();
+        flushes_completed_ = flush_target;
+        flushed_.notify_all();
+
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+TEST_CASE("[ltb][util][timer_sink] name ids are stable") {
+    auto const id = timer_name_id("timer sink test");
+    CHECK(timer_name_id("timer sink test") == id);
+    CHECK(timer_name_id("another timer sink test") != id);
+    CHECK(timer_name(id) == "timer sink test");
+    CHECK(timer_name(~std::uint32_t{0u}).empty());
+}
+
+TEST_CASE("[ltb][util][timer_sink] reports are written in the background") {
+    auto const first_id  = timer_name_id("first");
+    auto const second_id = timer_name_id("second");
+
+    auto stream = std::stringstream{};
+    {
+        auto sink = AsyncTimerSink(stream, 16u, duration_seconds(10));
+        sink.submit({first_id, 0, duration_micros(1500)});
+        sink.submit({second_id, 0, duration_millis(2)});
+
+        // The write interval is long so nothing is written until flushing.
+        sink.flush();
+        CHECK(stream.str() == "first: 1.500000ms\nsecond: 2.000000ms\n");
+
+        {
+            auto scoped_timer = ScopedTimer(sink, first_id);
+        }
+        for (auto i = 0; i < 20; ++i) {
+            sink.submit({second_id, 0, duration_millis(1)});
+        }
+    }
+    // Remaining reports are written on destruction
+    CHECK(stream.str().find("first: 1.500000ms\nsecond: 2.000000ms\nfirst: ") == 0u);
+}
+
+TEST_CASE("[ltb][util][timer_sink] full buffers drop reports instead of blocking") {
+    auto stream = std::stringstream{};
+    auto sink   = AsyncTimerSink(stream, 4u, duration_seconds(10));
+
+    auto const id = timer_name_id("dropped");
+    // The background thread may or may not have started draining so
+    // enough reports are submitted to overflow the buffer either way.
+    for (auto i = 0; i < 10'000; ++i) {
+        sink.submit({id, 0, duration_micros(i)});
+    }
+    sink.flush();
+    CHECK(sink.dropped() > 0u);
+
+    auto const output = stream.str();
+    auto const lines  = std::count(output.begin(), output.end(), '\n');
+    CHECK(static_cast<std::uint64_t>(lines) + sink.dropped() == 10'000u);
+}
+
+} // namespace ltb::util
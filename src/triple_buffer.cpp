@@ -0,0 +1,77 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/triple_buffer.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace ltb;
+
+TEST_CASE("[ltb][util][triple_buffer] reader sees the latest published value") {
+    auto buffer = util::TripleBuffer<int>{-1};
+
+    CHECK_FALSE(buffer.has_update());
+    CHECK(buffer.read() == -1);
+
+    buffer.write(1);
+    CHECK(buffer.has_update());
+    CHECK(buffer.read() == 1);
+    CHECK_FALSE(buffer.has_update());
+    CHECK(buffer.read() == 1); // Reading again without an update returns the same value
+
+    // Values that are never read are skipped
+    buffer.write(2);
+    buffer.write(3);
+    buffer.write(4);
+    CHECK(buffer.read() == 4);
+
+    // Nothing is visible until it is published
+    buffer.write_buffer() = 5;
+    CHECK_FALSE(buffer.has_update());
+    CHECK(buffer.read() == 4);
+    buffer.publish();
+    CHECK(buffer.read() == 5);
+}
+
+TEST_CASE("[ltb][util][triple_buffer] values are never torn or out of order") {
+    struct Frame {
+        std::vector<int> pixels = std::vector<int>(64, 0);
+    };
+    auto buffer = util::TripleBuffer<Frame>{};
+
+    constexpr auto frame_count = 20'000;
+
+    auto writer = std::thread([&buffer] {
+        for (auto f = 1; f <= frame_count; ++f) {
+            auto& frame = buffer.write_buffer();
+            std::fill(frame.pixels.begin(), frame.pixels.end(), f);
+            buffer.publish();
+        }
+    });
+
+    auto torn_frames      = 0;
+    auto backwards_frames = 0;
+    auto last_frame       = 0;
+    while (last_frame < frame_count) {
+        auto const& frame = buffer.read();
+        auto const  value = frame.pixels.front();
+
+        torn_frames += (std::count(frame.pixels.begin(), frame.pixels.end(), value) != 64) ? 1 : 0;
+        backwards_frames += (value < last_frame) ? 1 : 0;
+        last_frame = value;
+    }
+    writer.join();
+
+    CHECK(torn_frames == 0);
+    CHECK(backwards_frames == 0);
+}
+
+} // namespace
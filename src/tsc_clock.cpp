@@ -0,0 +1,127 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/tsc_clock.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+#if defined(LTB_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// standard
+#include <array>
+#include <thread>
+
+namespace ltb::util {
+namespace detail {
+namespace {
+
+#if defined(LTB_X86)
+auto cpuid(unsigned leaf) -> std::array<unsigned, 4> {
+    auto registers = std::array<unsigned, 4>{}; // eax, ebx, ecx, edx
+#if defined(_MSC_VER)
+    auto msvc_registers = std::array<int, 4>{};
+    __cpuid(msvc_registers.data(), static_cast<int>(leaf));
+    for (auto i = 0u; i < registers.size(); ++i) {
+        registers[i] = static_cast<unsigned>(msvc_registers[i]);
+    }
+#else
+    __get_cpuid(leaf, &registers[0], &registers[1], &registers[2], &registers[3]);
+#endif
+    return registers;
+}
+#endif
+
+/// \brief An invariant TSC ticks at a constant rate regardless of power states and is
+///        synchronized across cores, which is required to use it as a clock.
+auto has_invariant_tsc() -> bool {
+#if defined(LTB_X86)
+    constexpr auto edx = 3u;
+
+    auto const max_extended_leaf = cpuid(0x80000000u)[0];
+    if (max_extended_leaf < 0x80000007u) {
+        return false;
+    }
+    auto const has_rdtscp     = (cpuid(0x80000001u)[edx] & (1u << 27u)) != 0u;
+    auto const invariant_tsc = (cpuid(0x80000007u)[edx] & (1u << 8u)) != 0u;
+    return has_rdtscp && invariant_tsc;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+auto calibrate_tsc() -> TscCalibration {
+    auto calibration = TscCalibration{};
+
+    if (!has_invariant_tsc()) {
+        return calibration;
+    }
+
+    auto const start_nanos = steady_nanos();
+    auto const start_ticks = TscClock::read_ticks();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto const end_nanos = steady_nanos();
+    auto const end_ticks = TscClock::read_ticks();
+
+    if (end_ticks <= start_ticks || end_nanos <= start_nanos) {
+        return calibration;
+    }
+
+    auto const elapsed_ticks = static_cast<double>(end_ticks - start_ticks);
+    auto const elapsed_nanos = static_cast<double>(end_nanos - start_nanos);
+
+    calibration.use_tsc          = true;
+    calibration.base_ticks       = end_ticks;
+    calibration.base_nanos       = end_nanos;
+    calibration.nanos_per_tick   = elapsed_nanos / elapsed_ticks;
+    calibration.ticks_per_second = elapsed_ticks * 1.0e9 / elapsed_nanos;
+    return calibration;
+}
+
+} // namespace detail
+
+auto TscClock::calibrate() -> void {
+    static_cast<void>(detail::tsc_calibration());
+}
+
+TEST_CASE("[ltb][util][tsc_clock] time points are monotonic and track steady_clock") {
+    using namespace std::chrono_literals;
+
+    static_assert(TscClock::is_steady);
+    static_assert(std::is_same_v<TscClock::duration, Duration>);
+
+    if (TscClock::uses_tsc()) {
+        CHECK(TscClock::ticks_per_second() > 0.0);
+    } else {
+        CHECK(TscClock::ticks_per_second() == 0.0);
+    }
+
+    auto previous = TscClock::now();
+    for (auto i = 0; i < 1000; ++i) {
+        auto const current = TscClock::now();
+        CHECK(current >= previous);
+        previous = current;
+    }
+
+    // Both clocks share an epoch so they should measure roughly the same intervals
+    auto const steady_start = std::chrono::steady_clock::now();
+    auto const tsc_start    = TscClock::now();
+    std::this_thread::sleep_for(20ms);
+    auto const tsc_elapsed    = TscClock::now() - tsc_start;
+    auto const steady_elapsed = std::chrono::steady_clock::now() - steady_start;
+
+    CHECK(tsc_elapsed >= 19ms);
+    CHECK(to_millis<double>(tsc_elapsed) == doctest::Approx(to_millis<double>(steady_elapsed)).epsilon(0.05));
+}
+
+} // namespace ltb::util
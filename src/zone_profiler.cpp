@@ -0,0 +1,521 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2022 Logan Barnes - All Rights Reserved
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "ltb/util/zone_profiler.hpp"
+
+// project
+#include "ltb/util/ignore.hpp"
+#include "ltb/util/string.hpp"
+
+// external
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ltb::util {
+namespace {
+
+/// \brief The most recent zones recorded by a single thread, in a fixed-size ring. Only that
+///        thread writes to it but any thread can read the zones it has published.
+///
+/// Reads race with the writer overwriting old zones, so each slot is made of relaxed atomics
+/// and readers discard any zone the writer may have started overwriting while it was read
+/// (the same check a seqlock reader makes).
+class ZoneBuffer {
+public:
+    explicit ZoneBuffer(std::uint32_t thread_index)
+        : thread_index_(thread_index), slots_(std::make_unique<Slot[]>(zone_buffer_capacity)) {}
+
+    auto push(ZoneEvent const& event) -> void {
+        auto const index = published_.load(std::memory_order_relaxed);
+        auto&      slot  = slots_[index % zone_buffer_capacity];
+
+        claimed_.store(index + 1u, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.begin_nanos.store(event.begin_nanos, std::memory_order_relaxed);
+        slot.end_nanos.store(event.end_nanos, std::memory_order_relaxed);
+        slot.depth.store(event.depth, std::memory_order_relaxed);
+
+        published_.store(index + 1u, std::memory_order_release);
+    }
+
+    template <typename Func>
+    auto for_each(Func func) const -> void {
+        auto const count = published_.load(std::memory_order_acquire);
+        auto const first = std::max(first_.load(std::memory_order_relaxed), oldest(count));
+
+        auto events = std::vector<ZoneEvent>{};
+        events.reserve(count - first);
+        for (auto i = first; i < count; ++i) {
+            auto const& slot = slots_[i % zone_buffer_capacity];
+            events.push_back({
+                slot.name.load(std::memory_order_relaxed),
+                slot.begin_nanos.load(std::memory_order_relaxed),
+                slot.end_nanos.load(std::memory_order_relaxed),
+                slot.depth.load(std::memory_order_relaxed),
+            });
+        }
+
+        // Skip the zones that were overwritten, or were being overwritten, while they were copied.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto const valid_from = oldest(claimed_.load(std::memory_order_relaxed));
+        for (auto i = std::max(first, valid_from); i < count; ++i) {
+            func(events[i - first]);
+        }
+    }
+
+    auto clear() -> void { first_.store(published_.load(std::memory_order_acquire), std::memory_order_relaxed); }
+
+    /// \brief Forget every zone so the buffer can be handed to another thread. Only safe once
+    ///        the thread that was writing to it has exited.
+    auto reset(std::uint32_t thread_index) -> void {
+        thread_index_ = thread_index;
+        name.clear();
+        claimed_.store(0u, std::memory_order_relaxed);
+        published_.store(0u, std::memory_order_relaxed);
+        first_.store(0u, std::memory_order_relaxed);
+    }
+
+    /// \brief The number of zones recorded since the last `clear` that were overwritten.
+    [[nodiscard]] auto overwritten() const -> std::uint64_t {
+        auto const count = published_.load(std::memory_order_acquire);
+        auto const first = first_.load(std::memory_order_relaxed);
+        return oldest(count) > first ? oldest(count) - first : 0u;
+    }
+
+    [[nodiscard]] auto thread_index() const -> std::uint32_t { return thread_index_; }
+
+    std::string name; ///< Guarded by the registry mutex
+
+private:
+    struct Slot {
+        std::atomic<char const*>   name        = {nullptr};
+        std::atomic<std::int64_t>  begin_nanos = {0};
+        std::atomic<std::int64_t>  end_nanos   = {0};
+        std::atomic<std::uint32_t> depth       = {0u};
+    };
+
+    std::uint32_t              thread_index_;
+    std::unique_ptr<Slot[]>    slots_;
+    std::atomic<std::uint64_t> claimed_   = {0u}; ///< Bumped before a slot is written
+    std::atomic<std::uint64_t> published_ = {0u}; ///< Bumped after a slot is written
+    std::atomic<std::uint64_t> first_     = {0u}; ///< Zones before this were cleared
+
+    /// \brief The index of the oldest zone still in the ring once `count` zones have been written.
+    static auto oldest(std::uint64_t count) -> std::uint64_t {
+        return count > zone_buffer_capacity ? count - zone_buffer_capacity : 0u;
+    }
+};
+
+/// \brief The zones a thread recorded before it exited, copied out of its buffer so the
+///        buffer can be reused.
+struct ExitedThreadZones {
+    std::uint32_t          thread_index = 0u;
+    std::string            name         = {};
+    std::vector<ZoneEvent> events       = {};
+    std::uint64_t          overwritten  = 0u;
+};
+
+struct ZoneRegistry {
+    std::mutex                               mutex;
+    std::vector<std::unique_ptr<ZoneBuffer>> buffers;
+    std::vector<ZoneBuffer*>                 free_buffers; ///< Buffers of exited threads, ready for reuse
+    std::deque<ExitedThreadZones>            exited_threads;
+    std::size_t                              exited_thread_zones    = 0u; ///< Events in `exited_threads`
+    std::uint64_t                            dropped_exited_threads = 0u; ///< Zones lost with whole entries
+    std::uint32_t                            next_thread_index      = 0u;
+
+    /// \brief Keep the zones of an exited thread, dropping the oldest zones of previously
+    ///        exited threads to stay within `exited_thread_zone_capacity`.
+    auto keep(ExitedThreadZones exited) -> void {
+        exited_thread_zones += exited.events.size();
+        exited_threads.push_back(std::move(exited));
+
+        while (exited_thread_zones > exited_thread_zone_capacity) {
+            auto&      oldest = exited_threads.front();
+            auto const excess = exited_thread_zones - exited_thread_zone_capacity;
+
+            if (excess >= oldest.events.size()) {
+                exited_thread_zones -= oldest.events.size();
+                dropped_exited_threads += oldest.events.size() + oldest.overwritten;
+                exited_threads.pop_front();
+            } else {
+                oldest.events.erase(oldest.events.begin(), oldest.events.begin() + std::ptrdiff_t(excess));
+                oldest.overwritten += excess;
+                exited_thread_zones -= excess;
+            }
+        }
+    }
+};
+
+auto registry() -> ZoneRegistry& {
+    // Leaked on purpose so zones recorded by threads that have exited (or during
+    // static destruction) can still be exported.
+    static auto* registry = new ZoneRegistry();
+    return *registry;
+}
+
+std::atomic_bool profiling_enabled = {false};
+
+thread_local ZoneBuffer*   this_thread_buffer   = nullptr;
+thread_local bool          this_thread_released = false;
+thread_local std::uint32_t this_thread_depth    = 0u;
+
+/// \brief Hands the calling thread's buffer back to the registry when the thread exits.
+struct ZoneBufferOwner {
+    ~ZoneBufferOwner() {
+        auto&      zones = registry();
+        auto const lock  = std::lock_guard(zones.mutex);
+
+        // Zones recorded by later thread_local destructors on this thread are dropped.
+        this_thread_released = true;
+
+        auto* buffer = std::exchange(this_thread_buffer, nullptr);
+        if (!buffer) {
+            // Allocating the buffer failed after this owner was constructed.
+            return;
+        }
+
+        auto exited = ExitedThreadZones{buffer->thread_index(), buffer->name, {}, buffer->overwritten()};
+        buffer->for_each([&exited](ZoneEvent const& event) { exited.events.push_back(event); });
+        if (!exited.events.empty() || exited.overwritten > 0u) {
+            zones.keep(std::move(exited));
+        }
+
+        buffer->reset(0u);
+        zones.free_buffers.push_back(buffer);
+    }
+};
+
+/// \return The calling thread's buffer, or null if the thread is exiting and has already
+///         given its buffer back.
+auto zone_buffer() -> ZoneBuffer* {
+    if (!this_thread_buffer && !this_thread_released) {
+        // Constructed here so its destructor runs when this thread exits.
+        thread_local auto owner = ZoneBufferOwner{};
+        ignore(owner);
+
+        auto&      zones = registry();
+        auto const lock  = std::lock_guard(zones.mutex);
+
+        auto const index = zones.next_thread_index++;
+        if (zones.free_buffers.empty()) {
+            this_thread_buffer = zones.buffers.emplace_back(std::make_unique<ZoneBuffer>(index)).get();
+        } else {
+            this_thread_buffer = zones.free_buffers.back();
+            zones.free_buffers.pop_back();
+            this_thread_buffer->reset(index);
+        }
+    }
+    return this_thread_buffer;
+}
+
+auto to_nanos_since_epoch(TscClock::time_point time) -> std::int64_t {
+    return to_nanos<std::int64_t>(time.time_since_epoch());
+}
+
+} // namespace
+
+auto set_zone_profiling_enabled(bool enabled) -> void {
+    profiling_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto zone_profiling_enabled() -> bool {
+    return profiling_enabled.load(std::memory_order_relaxed);
+}
+
+auto set_zone_thread_name(std::string name) -> void {
+    if (auto* buffer = zone_buffer()) {
+        auto const lock = std::lock_guard(registry().mutex);
+        buffer->name    = std::move(name);
+    }
+}
+
+ScopedZone::ScopedZone(char const* name) : name_(name), begin_(), recording_(zone_profiling_enabled()) {
+    if (recording_) {
+        ++this_thread_depth;
+        begin_ = TscClock::now();
+    }
+}
+
+ScopedZone::~ScopedZone() {
+    if (recording_) {
+        auto const end = TscClock::now();
+        --this_thread_depth;
+        if (auto* buffer = zone_buffer()) {
+            buffer->push({name_, to_nanos_since_epoch(begin_), to_nanos_since_epoch(end), this_thread_depth});
+        }
+    }
+}
+
+auto write_chrome_trace(std::ostream& os) -> void {
+    auto&      zones = registry();
+    auto const lock  = std::lock_guard(zones.mutex);
+
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    auto separator = "\n";
+
+    // Restored at the end so the caller's stream formatting isn't changed.
+    auto const flags     = os.flags();
+    auto const precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+
+    auto const write_thread_name = [&](std::uint32_t thread_index, std::string const& name) {
+        if (!name.empty()) {
+            os << separator << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread_index
+               << R"(,"args":{"name":)" << to_json_string(name) << "}}";
+            separator = ",\n";
+        }
+    };
+    auto const write_zone = [&](std::uint32_t thread_index, ZoneEvent const& event) {
+        os << separator << R"({"name":)" << to_json_string(event.name) << R"(,"ph":"X","pid":1,"tid":)"
+           << thread_index << ",\"ts\":" << static_cast<double>(event.begin_nanos) / 1000.0
+           << ",\"dur\":" << static_cast<double>(event.end_nanos - event.begin_nanos) / 1000.0 << "}";
+        separator = ",\n";
+    };
+
+    for (auto const& buffer : zones.buffers) {
+        write_thread_name(buffer->thread_index(), buffer->name);
+        buffer->for_each([&](ZoneEvent const& event) { write_zone(buffer->thread_index(), event); });
+    }
+    for (auto const& exited : zones.exited_threads) {
+        write_thread_name(exited.thread_index, exited.name);
+        for (auto const& event : exited.events) {
+            write_zone(exited.thread_index, event);
+        }
+    }
+    os << "\n]}\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+auto write_chrome_trace(std::filesystem::path const& filename) -> Result<void> {
+    auto output_stream = std::ofstream(filename);
+
+    if (!output_stream.is_open()) {
+        return tl::make_unexpected(LTB_MAKE_ERROR("Failed to open: '" + filename.string() + "'"));
+    }
+
+    write_chrome_trace(output_stream);
+
+    if (!output_stream.flush()) {
+        return tl::make_unexpected(LTB_MAKE_ERROR("Failed to write: '" + filename.string() + "'"));
+    }
+    return success();
+}
+
+auto overwritten_zones() -> std::uint64_t {
+    auto&      zones = registry();
+    auto const lock  = std::lock_guard(zones.mutex);
+
+    auto total = std::uint64_t{0u};
+    for (auto const& buffer : zones.buffers) {
+        total += buffer->overwritten();
+    }
+    for (auto const& exited : zones.exited_threads) {
+        total += exited.overwritten;
+    }
+    return total + zones.dropped_exited_threads;
+}
+
+auto clear_zones() -> void {
+    auto&      zones = registry();
+    auto const lock  = std::lock_guard(zones.mutex);
+
+    for (auto const& buffer : zones.buffers) {
+        buffer->clear();
+    }
+    zones.exited_threads.clear();
+    zones.exited_thread_zones    = 0u;
+    zones.dropped_exited_threads = 0u;
+}
+
+namespace {
+
+auto count_occurrences(std::string const& str, std::string const& substr) -> std::size_t {
+    auto count = std::size_t{0u};
+    for (auto pos = str.find(substr); pos != std::string::npos; pos = str.find(substr, pos + substr.size())) {
+        ++count;
+    }
+    return count;
+}
+
+auto record_nested_zones() -> void {
+    LTB_PROFILE_ZONE("outer");
+    for (auto i = 0; i < 3; ++i) {
+        LTB_PROFILE_ZONE("inner");
+    }
+}
+
+TEST_CASE("[ltb][util][zone_profiler] zones are only recorded while enabled") {
+    clear_zones();
+    set_zone_profiling_enabled(false);
+    record_nested_zones();
+
+    auto stream = std::stringstream{};
+    write_chrome_trace(stream);
+    CHECK(count_occurrences(stream.str(), R"("ph":"X")") == 0u);
+}
+
+TEST_CASE("[ltb][util][zone_profiler] nested zones from several threads") {
+    clear_zones();
+    set_zone_profiling_enabled(true);
+
+    auto threads = std::array<std::thread, 4>{};
+    for (auto i = 0u; i < threads.size(); ++i) {
+        threads[i] = std::thread([i] {
+            set_zone_thread_name("worker \"" + std::to_string(i) + "\"");
+            for (auto j = 0; j < 400; ++j) {
+                record_nested_zones();
+            }
+        });
+    }
+    record_nested_zones();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    set_zone_profiling_enabled(false);
+
+    auto stream = std::stringstream{};
+    write_chrome_trace(stream);
+    auto const trace = stream.str();
+
+    CHECK(trace.find(R"({"displayTimeUnit":"ns","traceEvents":[)") == 0u);
+    CHECK(count_occurrences(trace, R"("name":"outer")") == 1601u);
+    CHECK(count_occurrences(trace, R"("name":"inner")") == 4803u);
+    CHECK(trace.find(R"("args":{"name":"worker \"2\""})") != std::string::npos);
+
+    // Exported zones are excluded after clearing
+    clear_zones();
+    stream = std::stringstream{};
+    write_chrome_trace(stream);
+    CHECK(count_occurrences(stream.str(), R"("ph":"X")") == 0u);
+}
+
+TEST_CASE("[ltb][util][zone_profiler] each thread keeps its most recent zones") {
+    clear_zones();
+    set_zone_profiling_enabled(true);
+    std::thread([] {
+        for (auto i = std::size_t{0u}; i < zone_buffer_capacity + 100u; ++i) {
+            LTB_PROFILE_ZONE("overwritten");
+        }
+        LTB_PROFILE_ZONE("last");
+    }).join();
+    set_zone_profiling_enabled(false);
+
+    CHECK(overwritten_zones() == 101u);
+
+    auto stream = std::stringstream{};
+    write_chrome_trace(stream);
+    auto const trace = stream.str();
+    CHECK(count_occurrences(trace, R"("ph":"X")") == zone_buffer_capacity);
+    CHECK(count_occurrences(trace, R"("name":"last")") == 1u);
+
+    // The caller's formatting is restored
+    stream = std::stringstream{};
+    stream << std::setprecision(2);
+    write_chrome_trace(stream);
+    stream.str("");
+    stream << 1.2345;
+    CHECK(stream.str() == "1.2");
+
+    clear_zones();
+    CHECK(overwritten_zones() == 0u);
+}
+
+TEST_CASE("[ltb][util][zone_profiler] buffers of exited threads are reused") {
+    clear_zones();
+    set_zone_profiling_enabled(true);
+
+    auto const buffer_count = [] {
+        auto const lock = std::lock_guard(registry().mutex);
+        return registry().buffers.size();
+    };
+
+    // Make sure at least one buffer is free
+    std::thread(record_nested_zones).join();
+    auto const buffers_before = buffer_count();
+
+    for (auto i = 0; i < 10; ++i) {
+        std::thread([i] {
+            set_zone_thread_name("transient " + std::to_string(i));
+            record_nested_zones();
+        }).join();
+    }
+    set_zone_profiling_enabled(false);
+
+    CHECK(buffer_count() == buffers_before);
+
+    // The zones of every exited thread are still exported under their own names
+    auto stream = std::stringstream{};
+    write_chrome_trace(stream);
+    auto const trace = stream.str();
+    CHECK(count_occurrences(trace, R"("name":"outer")") == 11u);
+    CHECK(trace.find(R"("args":{"name":"transient 0"})") != std::string::npos);
+    CHECK(trace.find(R"("args":{"name":"transient 9"})") != std::string::npos);
+
+    clear_zones();
+    stream = std::stringstream{};
+    write_chrome_trace(stream);
+    CHECK(count_occurrences(stream.str(), R"("ph":"X")") == 0u);
+}
+
+TEST_CASE("[ltb][util][zone_profiler] zones kept from exited threads are bounded") {
+    clear_zones();
+    set_zone_profiling_enabled(true);
+
+    // Three threads leave one and a half times as many zones as are kept
+    constexpr auto zones_per_thread = exited_thread_zone_capacity / 2u;
+    for (auto i = 0; i < 3; ++i) {
+        std::thread([] {
+            for (auto j = std::size_t{0u}; j < zones_per_thread; ++j) {
+                LTB_PROFILE_ZONE("exited");
+            }
+        }).join();
+    }
+    set_zone_profiling_enabled(false);
+
+    CHECK(overwritten_zones() == zones_per_thread);
+
+    auto stream = std::stringstream{};
+    write_chrome_trace(stream);
+    CHECK(count_occurrences(stream.str(), R"("ph":"X")") == exited_thread_zone_capacity);
+
+    clear_zones();
+    CHECK(overwritten_zones() == 0u);
+}
+
+TEST_CASE("[ltb][util][zone_profiler] write to a file") {
+    clear_zones();
+    set_zone_profiling_enabled(true);
+    record_nested_zones();
+    set_zone_profiling_enabled(false);
+
+    auto const filename = std::filesystem::temp_directory_path() / "ltb_util_zone_profiler_test.json";
+    CHECK(write_chrome_trace(filename).has_value());
+    CHECK(std::filesystem::file_size(filename) > 0u);
+    std::filesystem::remove(filename);
+
+    CHECK_FALSE(write_chrome_trace(std::filesystem::path("not") / "a" / "directory" / "trace.json").has_value());
+}
+
+} // namespace
+} // namespace ltb::util